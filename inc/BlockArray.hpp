@@ -0,0 +1,319 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __BLOCK_ARRAY__
+#define __BLOCK_ARRAY__
+
+#pragma once
+#include <new>
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <sys/mman.h>
+
+/**
+ * @brief Contiguous array of plain values for sets of tens of millions of particles, used like a std::vector.
+ *        The memory is mapped straight from the system in blocks of one huge page, aligned on them and marked for
+ *        transparent huge pages. Growing remaps the pages to a larger range instead of copying them, so adding
+ *        particles one by one never copies the whole array nor holds it twice in memory.
+ *        New elements are zero like in a std::vector, but the pages never used are left untouched: they are only
+ *        allocated by the first thread writing them
+ * @tparam T Type of the elements, copied as raw bytes
+*/
+template <typename T>
+class BlockArray{
+    static_assert(std::is_trivially_copyable<T>::value, "BlockArray only holds plain values");
+
+    public:
+
+        /**
+         * @brief Constructor of an empty array, nothing is mapped until it grows
+        */
+        BlockArray();
+
+        /**
+         * @brief Copy constructor, only maps the blocks needed by the copied elements
+        */
+        BlockArray(const BlockArray& other);
+
+        /**
+         * @brief Move constructor, the other array is left empty
+        */
+        BlockArray(BlockArray&& other) noexcept;
+
+        /**
+         * @brief Destructor, unmaps the blocks
+        */
+        ~BlockArray();
+
+        BlockArray& operator=(const BlockArray& other);
+        BlockArray& operator=(BlockArray&& other) noexcept;
+
+        /**
+         * @brief Change the number of elements, the new ones being zero. The capacity is kept when shrinking
+         * @param n The new number of elements
+        */
+        void resize(size_t n);
+
+        /**
+         * @brief Make room for n elements without changing the size
+         * @param n The number of elements
+        */
+        void reserve(size_t n);
+
+        /**
+         * @brief Add an element at the end
+         * @param value The element
+        */
+        void push_back(const T& value);
+
+        /**
+         * @brief Remove all the elements, keeping the capacity
+        */
+        void clear();
+
+        /**
+         * @brief Exchange the elements and the memory of two arrays
+         * @param other The other array
+        */
+        void swap(BlockArray& other);
+
+        size_t size() const;
+        size_t capacity() const;
+        bool empty() const;
+        T* data();
+        const T* data() const;
+        T& operator[](size_t i);
+        const T& operator[](size_t i) const;
+
+        static const size_t BLOCK_BYTES;  // Size of a block, one huge page
+
+    private:
+        /**
+         * @brief Grow the mapping to hold at least n elements, by a quarter of its size at least
+         * @param n The number of elements
+        */
+        void grow(size_t n);
+
+        /**
+         * @brief Map a new range of memory aligned on a block
+         * @param bytes Size of the range, a whole number of blocks
+        */
+        static void* mapBlocks(size_t bytes);
+
+        /**
+         * @brief Size of the mapped range
+        */
+        size_t mappedBytes() const;
+
+        T* _data;
+        size_t _size;
+        size_t _capacity;
+        size_t _touched;  // Elements beyond this one were never written and are still zero
+};
+
+template <typename T>
+const size_t BlockArray<T>::BLOCK_BYTES = 2 << 20;
+
+template <typename T>
+BlockArray<T>::BlockArray()
+    : _data {nullptr}
+    , _size {0}
+    , _capacity {0}
+    , _touched {0}
+    {}
+
+template <typename T>
+BlockArray<T>::BlockArray(const BlockArray& other)
+    : BlockArray()
+    {
+    *this = other;
+}
+
+template <typename T>
+BlockArray<T>::BlockArray(BlockArray&& other) noexcept
+    : _data {other._data}
+    , _size {other._size}
+    , _capacity {other._capacity}
+    , _touched {other._touched}
+    {
+    other._data = nullptr;
+    other._size = 0;
+    other._capacity = 0;
+    other._touched = 0;
+}
+
+template <typename T>
+BlockArray<T>::~BlockArray(){
+    if (_data != nullptr){
+        munmap(_data, mappedBytes());
+    }
+}
+
+template <typename T>
+BlockArray<T>& BlockArray<T>::operator=(const BlockArray& other){
+    if (this != &other){
+        reserve(other._size);
+        if (other._size != 0){
+            std::memcpy(_data, other._data, other._size * sizeof(T));
+        }
+        _size = other._size;
+        _touched = std::max(_touched, _size);
+    }
+    return *this;
+}
+
+template <typename T>
+BlockArray<T>& BlockArray<T>::operator=(BlockArray&& other) noexcept{
+    if (this != &other){
+        swap(other);
+    }
+    return *this;
+}
+
+template <typename T>
+void BlockArray<T>::resize(size_t n){
+    if (n > _size){
+        reserve(n);
+        // Only the elements written before need to be cleared, the others are on pages still zero
+        size_t used = std::min(n, _touched);
+        if (used > _size){
+            std::memset(_data + _size, 0, (used - _size) * sizeof(T));
+        }
+        _touched = std::max(_touched, n);
+    }
+    _size = n;
+}
+
+template <typename T>
+void BlockArray<T>::reserve(size_t n){
+    if (n > _capacity){
+        grow(n);
+    }
+}
+
+template <typename T>
+void BlockArray<T>::push_back(const T& value){
+    if (_size == _capacity){
+        grow(_size + 1);
+    }
+    _data[_size++] = value;
+    _touched = std::max(_touched, _size);
+}
+
+template <typename T>
+void BlockArray<T>::clear(){
+    _size = 0;
+}
+
+template <typename T>
+void BlockArray<T>::swap(BlockArray& other){
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    std::swap(_capacity, other._capacity);
+    std::swap(_touched, other._touched);
+}
+
+template <typename T>
+size_t BlockArray<T>::size() const{
+    return _size;
+}
+
+template <typename T>
+size_t BlockArray<T>::capacity() const{
+    return _capacity;
+}
+
+template <typename T>
+bool BlockArray<T>::empty() const{
+    return _size == 0;
+}
+
+template <typename T>
+T* BlockArray<T>::data(){
+    return _data;
+}
+
+template <typename T>
+const T* BlockArray<T>::data() const{
+    return _data;
+}
+
+template <typename T>
+T& BlockArray<T>::operator[](size_t i){
+    return _data[i];
+}
+
+template <typename T>
+const T& BlockArray<T>::operator[](size_t i) const{
+    return _data[i];
+}
+
+template <typename T>
+void BlockArray<T>::grow(size_t n){
+    size_t old_bytes = mappedBytes();
+    size_t bytes = std::max(n * sizeof(T), old_bytes + old_bytes / 4);
+    bytes = (bytes + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+
+    void* data;
+    if (_data == nullptr){
+        data = mapBlocks(bytes);
+    }
+    else {
+#ifdef __linux__
+        // Extended in place when the following addresses are free, otherwise the pages are moved, never copied
+        data = mremap(_data, old_bytes, bytes, 0);
+        if (data == MAP_FAILED){
+            data = mremap(_data, old_bytes, bytes, MREMAP_MAYMOVE);
+        }
+        if (data == MAP_FAILED){
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(data, bytes, MADV_HUGEPAGE);
+#endif
+#else
+        data = mapBlocks(bytes);
+        std::memcpy(data, _data, _touched * sizeof(T));
+        munmap(_data, old_bytes);
+#endif
+    }
+
+    _data = static_cast<T*>(data);
+    _capacity = bytes / sizeof(T);
+}
+
+template <typename T>
+size_t BlockArray<T>::mappedBytes() const{
+    return (_capacity * sizeof(T) + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES;
+}
+
+template <typename T>
+void* BlockArray<T>::mapBlocks(size_t bytes){
+    // One more block than needed, so that a range aligned on a block can be cut out of it
+    size_t length = bytes + BLOCK_BYTES;
+    void* mapped = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED){
+        throw std::bad_alloc();
+    }
+
+    char* begin = static_cast<char*>(mapped);
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + BLOCK_BYTES - 1) / BLOCK_BYTES * BLOCK_BYTES);
+    if (aligned != begin){
+        munmap(begin, aligned - begin);
+    }
+    if (aligned + bytes != begin + length){
+        munmap(aligned + bytes, begin + length - (aligned + bytes));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+#endif
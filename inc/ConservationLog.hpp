@@ -0,0 +1,88 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __CONSERVATION_LOG__
+#define __CONSERVATION_LOG__
+
+#pragma once
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Conserved quantities of a set of particles at one step, the radius being used as mass
+*/
+struct ConservationSample {
+    uint64_t step = 0;
+    size_t nbParticles = 0;
+    double kinetic = 0;                      // Kinetic energy of the moving particles
+    double potential = 0;                    // Gravitational energy of every pair, given by the gravity solver
+    double momentum[3] = {0, 0, 0};          // Linear momentum
+    double angularMomentum[3] = {0, 0, 0};   // Angular momentum about the black hole (particle 0)
+};
+
+/**
+ * @brief Writes a time series of conservation samples to a CSV file and tracks how far they drift from the first one
+*/
+class ConservationLog{
+    public:
+
+        /**
+         * @brief Constructor, nothing is written until open() is called
+        */
+        ConservationLog();
+
+        /**
+         * @brief Destructor, closes the file
+        */
+        ~ConservationLog();
+
+        /**
+         * @brief Create the file and write the header of the columns
+         * @param path Path of the file
+         * @return false if the file cannot be created
+        */
+        bool open(const char* path);
+
+        /**
+         * @brief Append a sample, the first one being the reference of the drifts
+         * @param sample The sample
+        */
+        void record(const ConservationSample& sample);
+
+        /**
+         * @brief Flush and close the file
+        */
+        void close();
+
+        /**
+         * @brief Whether a file is open
+        */
+        bool isOpen() const;
+
+        /**
+         * @brief Number of samples recorded
+        */
+        size_t sampleCount() const;
+
+        /**
+         * @brief Largest |E - E0| / |E0| over the samples, E being the total energy
+        */
+        double maxEnergyDrift() const;
+
+        /**
+         * @brief Largest |L - L0| / |L0| over the samples, L being the angular momentum
+        */
+        double maxAngularMomentumDrift() const;
+
+    private:
+        FILE* _file;
+        size_t _samples;
+        ConservationSample _first;
+        double _maxEnergyDrift;
+        double _maxAngularMomentumDrift;
+};
+
+#endif
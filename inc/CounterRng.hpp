@@ -0,0 +1,55 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __COUNTER_RNG__
+#define __COUNTER_RNG__
+
+#pragma once
+#include <cstdint>
+
+/**
+ * @brief Counter-based random generator: the n-th number of a stream is a hash of (seed, stream, n), computed
+ *        with the SplitMix64 mixing function. Giving each particle its own stream (its index) makes a scene
+ *        depend only on the seed, whatever the order or the number of threads used to generate it.
+*/
+class CounterRng{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param seed Seed of the run
+         * @param stream Number of the stream, typically the index of the particle being generated
+        */
+        CounterRng(uint64_t seed, uint64_t stream);
+
+        /**
+         * @brief Next 64 bits integer of the stream
+        */
+        uint64_t nextUInt();
+
+        /**
+         * @brief Next integer of the stream in [0, bound[
+         * @param bound The excluded upper bound, must not be 0
+        */
+        uint64_t nextUInt(uint64_t bound);
+
+        /**
+         * @brief Next real of the stream in [0, 1[
+        */
+        double nextDouble();
+
+        /**
+         * @brief Next real of the stream in [min, max[
+         * @param min The included lower bound
+         * @param max The excluded upper bound
+        */
+        double uniform(double min, double max);
+
+    private:
+        uint64_t _key;      // Mix of the seed and the stream
+        uint64_t _counter;  // Number of values drawn from the stream
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __DOMAIN_DECOMPOSITION__
+#define __DOMAIN_DECOMPOSITION__
+
+#pragma once
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "Octree.hpp"
+#include "Softening.hpp"
+
+/**
+ * @brief Gravity of a set of particles computed by worker processes, one per spatial domain.
+ *        At each step the set is cut into boxes by orthogonal recursive bisection: the longest side of a box is split so
+ *        that both halves cost the same, each particle weighing the measured time per particle of the domain it was in.
+ *        Each worker builds the octree of its domain, then describes it to the other domains: the cells too far to be
+ *        opened from a domain are sent as single bodies (tree summaries), the particles of the others as ghosts.
+ *        Each worker finally computes the accelerations of its particles on a tree of its particles and of the bodies
+ *        it received. The positions, the domains, the exported bodies and the accelerations are exchanged through
+ *        shared memory, the steps are driven through a Unix socket per worker
+ * @tparam T Type of the positions
+ * @tparam TOffset Type of the masses and accelerations, and of the force kernel
+*/
+template <typename T, typename TOffset = T>
+class DomainDecomposition{
+    public:
+
+        /**
+         * @brief Constructor, no worker runs until start() is called
+        */
+        DomainDecomposition();
+
+        /**
+         * @brief Destructor, stops the workers
+        */
+        ~DomainDecomposition();
+
+        DomainDecomposition(const DomainDecomposition&) = delete;
+        DomainDecomposition& operator=(const DomainDecomposition&) = delete;
+
+        /**
+         * @brief Map the shared memory and fork the workers
+         * @param nb_domains Number of domains, one worker process each
+         * @param capacity Largest number of particles
+         * @return false if the workers could not be started
+        */
+        bool start(uint nb_domains, size_t capacity);
+
+        /**
+         * @brief Stop the workers and unmap the shared memory
+        */
+        void stop();
+
+        /**
+         * @brief Whether the workers are running
+        */
+        bool isRunning() const;
+
+        /**
+         * @brief Prepare the arrays of the workers and cut the domains on a pool of threads
+         * @param pool The threads, the calling thread doing everything if null. It must outlive the decomposition
+        */
+        void setWorkerPool(WorkerPool* pool);
+
+        /**
+         * @brief Compute the gravitational acceleration of every particle on the workers
+         * @param G The gravitational constant
+         * @param softening Shape of the force at short distance
+         * @param x Array of x coordinates
+         * @param y Array of y coordinates
+         * @param z Array of z coordinates
+         * @param mass Array of masses
+         * @param n The number of particles
+         * @param ax Array receiving the x component of the accelerations
+         * @param ay Array receiving the y component of the accelerations
+         * @param az Array receiving the z component of the accelerations
+         * @param phi Array receiving the gravitational potentials, ignored if null
+         * @return false if nothing was computed: more particles than the capacity, or a worker stopped answering,
+         *         in which case the workers are stopped
+        */
+        bool computeAccelerations(double G, const Softening<TOffset>& softening, const T* x, const T* y, const T* z,
+                                  const TOffset* mass, size_t n, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi = nullptr);
+
+        /**
+         * @brief Number of domains
+        */
+        uint domainCount() const;
+
+        /**
+         * @brief Number of steps computed by the workers
+        */
+        uint64_t stepCount() const;
+
+        /**
+         * @brief Time of the slowest domain over the average time of a domain, for the last step
+        */
+        double lastImbalance() const;
+
+        /**
+         * @brief Time of the slowest domain over the average time of a domain, averaged over the steps
+        */
+        double meanImbalance() const;
+
+        /**
+         * @brief Average number of bodies a domain received per step, ghost particles and cells
+        */
+        double meanImportedBodies() const;
+
+        static const uint MAX_DOMAINS;
+
+    private:
+        /**
+         * @brief Body sent from a domain to another one, a ghost particle or a cell
+        */
+        struct Body {
+            T x;
+            T y;
+            T z;
+            TOffset mass;
+        };
+
+        /**
+         * @brief Parameters of the current step, in the shared memory
+        */
+        struct Header {
+            uint64_t n;
+            uint32_t potential;  // Whether the potentials are computed
+            uint32_t kernel;     // Softening kernel and length
+            double softening;
+            double G;
+        };
+
+        /**
+         * @brief Arrays of a worker, for the particles of its domain followed by the bodies it received
+        */
+        struct WorkerArrays {
+            std::vector<T> x;
+            std::vector<T> y;
+            std::vector<T> z;
+            std::vector<TOffset> mass;
+            std::vector<TOffset> ax;
+            std::vector<TOffset> ay;
+            std::vector<TOffset> az;
+            std::vector<TOffset> phi;
+        };
+
+        /**
+         * @brief Commands sent to the workers
+        */
+        enum Command : uint32_t {
+            COMMAND_EXPORT,   // Build the tree of the domain and write the bodies needed by the others
+            COMMAND_COMPUTE,  // Compute the accelerations of the domain from its particles and the bodies received
+            COMMAND_STOP
+        };
+
+        /**
+         * @brief Node of the bisection, the particles below value along axis going to the first half of the domains.
+         *        The children of node k are the nodes 2k + 1 and 2k + 2
+        */
+        struct Split {
+            int axis;
+            double value;
+        };
+
+        /**
+         * @brief Cut the particles of order[begin, end[ into count domains starting at first
+         * @param begin First position in the order of the domains
+         * @param end Last position (excluded)
+         * @param first First domain
+         * @param count Number of domains
+         * @param split Node of the bisection
+        */
+        void bisect(size_t begin, size_t end, uint first, uint count, size_t split);
+
+        /**
+         * @brief Domain of the last bisection a position falls in
+         * @param position The position
+        */
+        uint locate(const double position[3]) const;
+
+        /**
+         * @brief Send a command to every worker and wait for their answers
+         * @param command The command
+         * @return false if a worker did not answer
+        */
+        bool broadcast(Command command);
+
+        /**
+         * @brief Loop of a worker process, never returns
+         * @param domain Domain of the worker
+         * @param socket Its end of the socket
+        */
+        void workerMain(uint domain, int socket);
+
+        /**
+         * @brief Worker side of COMMAND_EXPORT: gather the particles of the domain, build their tree and write
+         *        the bodies each other domain needs
+         * @param domain Domain of the worker
+         * @param tree Tree of the domain
+         * @param arrays Receive the particles of the domain
+        */
+        void exportBodies(uint domain, Octree<T, TOffset>& tree, WorkerArrays& arrays);
+
+        /**
+         * @brief Worker side of COMMAND_COMPUTE: add the bodies received to the particles of the domain, and compute
+         *        the accelerations of the particles on the tree of both
+         * @param domain Domain of the worker
+         * @param tree Tree of the particles and of the bodies
+         * @param arrays Particles of the domain, the bodies being appended
+        */
+        void computeDomain(uint domain, Octree<T, TOffset>& tree, WorkerArrays& arrays);
+
+        uint _nbDomains;
+        size_t _capacity;
+        void* _shared;             // Mapping shared with the workers
+        size_t _sharedBytes;
+        Header* _header;
+        double* _lo;               // Bounding box of each domain, 3 coordinates per domain
+        double* _hi;
+        uint64_t* _domainStart;    // Particles of domain d are _order[_domainStart[d]] to _order[_domainStart[d + 1] - 1]
+        uint64_t* _exportStart;    // Bodies sent from domain d to domain e are _bodies[_exportStart[d * domains + e]] onwards
+        uint64_t* _exportCount;
+        T* _x;                     // Shared arrays, by particle index
+        T* _y;
+        T* _z;
+        TOffset* _mass;
+        TOffset* _ax;
+        TOffset* _ay;
+        TOffset* _az;
+        TOffset* _phi;
+        uint32_t* _order;          // Particles grouped by domain
+        Body* _bodies;             // Bodies exported by the domains, domain d writing from (domains - 1) * _domainStart[d]
+
+        std::vector<int> _sockets;
+        std::vector<pid_t> _workers;
+        WorkerPool* _pool;         // Threads of the coordinator, none if null
+
+        // Bisection, in the coordinator
+        std::vector<double> _weights;      // Cost of each particle
+        std::vector<Split> _splits;        // Nodes of the last bisection, in the order of the recursion
+        std::vector<double> _cost;         // Seconds spent by each domain during the last step
+        std::vector<double> _costPerParticle;
+
+        uint64_t _steps;
+        double _lastImbalance;
+        double _imbalanceSum;
+        double _importedSum;
+};
+
+#endif
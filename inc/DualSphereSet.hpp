@@ -0,0 +1,94 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __DUAL_SPHERE_SET__
+#define __DUAL_SPHERE_SET__
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <c3ga/Mvec.hpp>
+
+/**
+ * @brief Coefficients of a set of c3ga dual spheres s = e0 + x e1 + y e2 + z e3 + 0.5 (x^2 + y^2 + z^2 - r^2) ei,
+ *        stored as one array per basis vector so that contact tests can be evaluated in bulk.
+ *        Since s_i.s_j = (r_i^2 + r_j^2 - d^2) / 2, the spheres touch when s_i.s_j >= -r_i r_j, no square root needed.
+ * @tparam T float or double
+*/
+template <typename T>
+class DualSphereSet{
+    public:
+
+        /**
+         * @brief Constructor, the origin is (0, 0, 0)
+        */
+        DualSphereSet();
+
+        /**
+         * @brief Set the point the coordinates are taken relative to. Contacts do not depend on it,
+         *        but choosing it close to the spheres keeps the ei coefficients small, which matters in float
+         * @param x The x coordinate of the origin
+         * @param y The y coordinate of the origin
+         * @param z The z coordinate of the origin
+        */
+        void setOrigin(double x, double y, double z);
+
+        /**
+         * @brief Change the number of spheres of the set
+         * @param n The new number of spheres
+        */
+        void resize(size_t n);
+
+        /**
+         * @brief Number of spheres in the set
+        */
+        size_t size() const;
+
+        /**
+         * @brief Set a sphere from its center and its radius
+         * @param i Index of the sphere
+         * @param x The x coordinate of the center
+         * @param y The y coordinate of the center
+         * @param z The z coordinate of the center
+         * @param radius The radius of the sphere
+        */
+        void setSphere(size_t i, double x, double y, double z, double radius);
+
+        /**
+         * @brief Set a sphere from a c3ga dual sphere
+         * @param i Index of the sphere
+         * @param dualSphere The dual sphere, its e0 coefficient must not be 0
+         * @param radius The radius of the sphere
+        */
+        void setSphere(size_t i, const c3ga::Mvec<double>& dualSphere, double radius);
+
+        /**
+         * @brief Inner product s_i.s_j of two spheres of the set
+         * @param i Index of the first sphere
+         * @param j Index of the second sphere
+        */
+        T innerProduct(size_t i, size_t j) const;
+
+        /**
+         * @brief Evaluate the contact predicate on a list of candidate pairs
+         * @param first Index of the first sphere of each pair
+         * @param second Index of the second sphere of each pair
+         * @param nb_pairs The number of pairs
+         * @param in_contact Array receiving 1 for each pair in contact, 0 otherwise
+        */
+        void testContacts(const uint32_t* first, const uint32_t* second, size_t nb_pairs, uint8_t* in_contact) const;
+
+    private:
+        std::vector<T> _e1;
+        std::vector<T> _e2;
+        std::vector<T> _e3;
+        std::vector<T> _ei;
+        std::vector<T> _radius;
+        double _origin[3];
+};
+
+#endif
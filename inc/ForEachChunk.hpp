@@ -0,0 +1,47 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __FOR_EACH_CHUNK__
+#define __FOR_EACH_CHUNK__
+
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <sys/types.h>
+
+/**
+ * @brief Call f(chunk, begin, end) on the chunks of [0, n[, spread over threads taking the next chunk when they are done
+ * @param n The number of items
+ * @param chunk_size The number of items of a chunk
+ * @param nb_threads The number of threads, 0 for one per hardware thread
+ * @param f The function called on each chunk
+*/
+template <typename F>
+void forEachChunk(size_t n, size_t chunk_size, uint nb_threads, F f){
+    std::atomic<size_t> next_chunk {0};
+    size_t nb_chunks = (n + chunk_size - 1) / chunk_size;
+
+    auto run = [&](){
+        for (size_t chunk = next_chunk++; chunk < nb_chunks; chunk = next_chunk++){
+            f(chunk, chunk * chunk_size, std::min(n, (chunk + 1) * chunk_size));
+        }
+    };
+
+    nb_threads = nb_threads != 0 ? nb_threads : std::max(1u, std::thread::hardware_concurrency());
+    nb_threads = std::min<size_t>(nb_threads, nb_chunks);
+    std::vector<std::thread> threads;
+    for (uint t = 1; t < nb_threads; t++){
+        threads.emplace_back(run);
+    }
+    run();
+    for (std::thread& thread : threads){
+        thread.join();
+    }
+}
+
+#endif
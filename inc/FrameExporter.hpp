@@ -0,0 +1,152 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __FRAME_EXPORTER__
+#define __FRAME_EXPORTER__
+
+#pragma once
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "Rasterizer.hpp"
+
+/**
+ * @brief Formats of the exported frames
+*/
+enum FrameFormat {
+    FRAME_PNG,      // One PNG file per frame, named from a printf pattern taking the frame number as an int
+    FRAME_RAW_RGB   // Frames appended to one file or pipe as rows of 8-bit RGB triplets, without any header
+};
+
+/**
+ * @brief Which frames are exported and how
+*/
+struct FrameExportOptions {
+    uint exportEvery = 1;     // Export one frame out of exportEvery
+    uint nbThreads = 2;       // Number of encoder threads, few so that they leave the CPUs to the physics
+    uint queueCapacity = 8;   // Number of frames waiting to be encoded before new ones are dropped
+    bool wait = false;        // Wait for a free place in the queue instead of dropping the frame
+};
+
+/**
+ * @brief Writes the frames drawn by a Rasterizer from a pool of encoder threads, without any window.
+ *        The caller swaps the pixel buffer of the rasterizer with a free one of the queue, which costs nothing,
+ *        and goes on. The encoder threads take the frames in order: PNG files are encoded in parallel, raw frames are
+ *        converted in parallel and appended in order. Frames arriving while the queue is full are dropped rather than
+ *        waiting for the encoders, unless asked otherwise
+*/
+class FrameExporter{
+    public:
+
+        /**
+         * @brief Constructor, nothing is written until open() is called
+        */
+        FrameExporter();
+
+        /**
+         * @brief Destructor, closes the output
+        */
+        ~FrameExporter();
+
+        /**
+         * @brief Start the encoder threads. The format follows the path: a pattern ending in ".png" gives one PNG per
+         *        frame ("frames/%05d.png"), a path starting with '|' pipes raw RGB frames to a command
+         *        ("|ffmpeg -f rawvideo -pix_fmt rgb24 -s 1200x800 -i - out.mp4"), any other path is a raw RGB file
+         * @param path Pattern, command or path of the output
+         * @param width Width of the frames
+         * @param height Height of the frames
+         * @param options Which frames are exported and how
+         * @return false if the output could not be created
+        */
+        bool open(const char* path, uint width, uint height, const FrameExportOptions& options);
+
+        /**
+         * @brief Hand the last frame drawn by a rasterizer to the encoders, if the frame is sampled.
+         *        Its pixel buffer is exchanged with a free one, that the next render overwrites.
+         *        Never blocks unless the options ask to wait
+         * @param rasterizer The rasterizer, of the size given to open()
+         * @return false if the frame was dropped because the queue was full
+        */
+        bool record(Rasterizer& rasterizer);
+
+        /**
+         * @brief Encode the frames still queued, stop the encoder threads and close the output
+        */
+        void close();
+
+        /**
+         * @brief Whether an output is open
+        */
+        bool isOpen() const;
+
+        /**
+         * @brief Format of the output
+        */
+        FrameFormat format() const;
+
+        /**
+         * @brief Number of frames written so far
+        */
+        uint64_t framesWritten() const;
+
+        /**
+         * @brief Number of frames dropped because the queue was full
+        */
+        uint64_t framesDropped() const;
+
+    private:
+        /**
+         * @brief A frame of the queue, free when its number is -1
+        */
+        struct Slot {
+            std::vector<uint32_t> pixels;
+            int64_t frame = -1;
+        };
+
+        /**
+         * @brief Loop of an encoder thread: take the next frame number, wait for it, encode it, until close() is called
+        */
+        void encoderLoop();
+
+        /**
+         * @brief Write a frame to the output
+         * @param pixels ARGB pixels of the frame
+         * @param frame Number of the frame among the exported ones
+         * @param rgb Buffer of the thread for the raw frames
+        */
+        void encode(const std::vector<uint32_t>& pixels, uint64_t frame, std::vector<uint8_t>& rgb);
+
+        FrameFormat _format;
+        FrameExportOptions _options;
+        std::string _pattern;
+        uint _width;
+        uint _height;
+        FILE* _file;
+        bool _pipe;
+
+        std::vector<Slot> _slots;          // Frame n waits in _slots[n % queueCapacity]
+        std::vector<std::thread> _threads;
+        std::mutex _mutex;                 // Protects the frames of the slots and the counters below
+        std::condition_variable _frameReady;
+        std::condition_variable _slotFree;
+        std::condition_variable _frameWritten;
+        bool _stop;
+        uint64_t _offered;                 // Frames given to record(), sampled or not
+        uint64_t _published;               // Frames queued so far, the next one is frame _published
+        uint64_t _nextFrame;               // Next frame taken by an encoder thread
+        uint64_t _nextWrite;               // Next raw frame appended to the output
+
+        std::atomic<uint64_t> _framesWritten;
+        std::atomic<uint64_t> _framesDropped;
+};
+
+#endif
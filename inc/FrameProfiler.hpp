@@ -0,0 +1,167 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __FRAME_PROFILER__
+#define __FRAME_PROFILER__
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+
+/**
+ * @brief Phases of a frame of the main loop
+*/
+enum FramePhase {
+    PHASE_GRAVITY,
+    PHASE_DRAW,
+    PHASE_PRESENT,
+    PHASE_MOVE,
+    PHASE_COLLISION,
+    PHASE_SNAPSHOT,   // Copy of the state for the render thread
+    PHASE_SLEEP,
+    PHASE_COUNT
+};
+
+/**
+ * @brief Timestamps of one frame, in nanoseconds of the steady clock. A phase that did not run has begin == end
+*/
+struct FrameRecord {
+    uint64_t index;                   // Number of the frame since the start
+    uint64_t begin;
+    uint64_t end;
+    uint64_t phaseBegin[PHASE_COUNT];
+    uint64_t phaseEnd[PHASE_COUNT];
+};
+
+/**
+ * @brief Records the duration of the phases of each frame in a fixed size ring buffer.
+ *        A single thread writes, any thread may read: a frame is published by incrementing an atomic counter,
+ *        and readers drop the frames overwritten while they were copying them, each slot carrying a sequence number
+ *        that is odd while the writer overwrites it.
+*/
+class FrameProfiler{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param capacity Number of frames kept, the oldest ones are overwritten
+        */
+        FrameProfiler(size_t capacity = 4096);
+
+        /**
+         * @brief Current time of the steady clock, in nanoseconds
+        */
+        static uint64_t now();
+
+        /**
+         * @brief Name of a phase, as shown in traces
+         * @param phase The phase
+        */
+        static const char* phaseName(FramePhase phase);
+
+        /**
+         * @brief Start recording a new frame
+        */
+        void beginFrame();
+
+        /**
+         * @brief Publish the frame being recorded in the ring buffer
+        */
+        void endFrame();
+
+        /**
+         * @brief Mark the start of a phase of the current frame
+         * @param phase The phase
+        */
+        void beginPhase(FramePhase phase);
+
+        /**
+         * @brief Mark the end of a phase of the current frame
+         * @param phase The phase
+        */
+        void endPhase(FramePhase phase);
+
+        /**
+         * @brief Number of frames published since the start
+        */
+        uint64_t frameCount() const;
+
+        /**
+         * @brief Number of frames kept in the ring buffer
+        */
+        size_t capacity() const;
+
+        /**
+         * @brief Copy a published frame
+         * @param index Number of the frame, between frameCount() - capacity() and frameCount() - 1
+         * @param frame Receives the frame
+         * @return false if the frame is not (or no longer) in the ring buffer
+        */
+        bool getFrame(uint64_t index, FrameRecord& frame) const;
+
+        /**
+         * @brief Average duration of a phase over the last frames, in milliseconds
+         * @param phase The phase
+         * @param nb_frames The number of frames to average
+        */
+        double averagePhaseDuration(FramePhase phase, size_t nb_frames) const;
+
+        /**
+         * @brief Write the frames kept in the ring buffer as a Chrome trace-event JSON file (chrome://tracing, Perfetto)
+         * @param path Path of the file to write
+         * @param other Profiler of another thread written next to this one as a second track, ignored if null
+         * @return false if the file could not be written
+        */
+        bool writeChromeTrace(const char* path, const FrameProfiler* other = nullptr) const;
+
+    private:
+        /**
+         * @brief Write the frames kept in the ring buffer as trace events
+         * @param file The file being written
+         * @param tid The track of the events
+         * @param first_event Whether no event was written yet, updated
+        */
+        void writeEvents(FILE* file, int tid, bool& first_event) const;
+
+        /**
+         * @brief Slot of the ring buffer, the record being copied in and out word by word with atomic accesses
+        */
+        struct Slot {
+            std::atomic<uint64_t> sequence {0};  // 2 (index + 1) once frame index is written, odd while it is overwritten
+            std::atomic<uint64_t> words[sizeof(FrameRecord) / sizeof(uint64_t)];
+        };
+
+        std::vector<Slot> _frames;
+        std::atomic<uint64_t> _published;  // Number of frames published, the next one goes to _frames[_published % capacity]
+        FrameRecord _current;              // Frame being recorded, only seen by the writer
+};
+
+/**
+ * @brief Times a phase from its construction to the end of its scope
+*/
+class ProfileScope{
+    public:
+
+        /**
+         * @brief Constructor, starts the phase
+         * @param profiler The profiler recording the phase
+         * @param phase The phase
+        */
+        ProfileScope(FrameProfiler& profiler, FramePhase phase);
+
+        /**
+         * @brief Destructor, ends the phase
+        */
+        ~ProfileScope();
+
+    private:
+        FrameProfiler& _profiler;
+        FramePhase _phase;
+};
+
+#endif
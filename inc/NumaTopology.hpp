@@ -0,0 +1,62 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __NUMA_TOPOLOGY__
+#define __NUMA_TOPOLOGY__
+
+#pragma once
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+/**
+ * @brief A memory node and the CPUs attached to it
+*/
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;     // CPUs of the node the process is allowed to run on
+    uint64_t memoryBytes = 0;  // Memory of the node, 0 if unknown
+};
+
+/**
+ * @brief NUMA nodes of the machine, read from /sys/devices/system/node on Linux.
+ *        Without it, the machine is seen as a single node holding every CPU the process may run on
+*/
+class NumaTopology{
+    public:
+
+        /**
+         * @brief Read the topology of the machine
+        */
+        static NumaTopology detect();
+
+        /**
+         * @brief Nodes of the machine, by increasing identifier
+        */
+        const std::vector<NumaNode>& nodes() const;
+
+        /**
+         * @brief Number of CPUs the process may run on
+        */
+        size_t cpuCount() const;
+
+        /**
+         * @brief Write the nodes, their CPUs and their memory
+         * @param out The stream written to
+        */
+        void print(FILE* out) const;
+
+        /**
+         * @brief Write a list of CPUs as ranges, "0-7,16-23"
+         * @param out The stream written to
+         * @param cpus The CPUs, sorted
+        */
+        static void printCpus(FILE* out, const std::vector<int>& cpus);
+
+    private:
+        std::vector<NumaNode> _nodes;
+};
+
+#endif
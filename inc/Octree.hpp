@@ -0,0 +1,437 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __OCTREE__
+#define __OCTREE__
+
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+#include "Softening.hpp"
+#include "BlockArray.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * @brief Cell of the octree, positions are taken relative to the center of the root
+*/
+template <typename TOffset>
+struct OctreeNode {
+    TOffset center[3];   // Center of the cubic cell
+    TOffset halfSize;    // Half of the width of the cell
+    TOffset mass;        // Total mass of the particles inside the cell
+    TOffset com[3];      // Center of mass of the particles inside the cell
+    TOffset maxRadius;   // Biggest particle radius inside the cell, used to bound contact queries
+    uint32_t firstChild; // Index of the first of the 8 children in the node array, 0 for a leaf
+    uint32_t begin;      // First entry of the cell's particles
+    uint32_t end;        // Last entry (excluded) of the cell's particles
+};
+
+/**
+ * @brief Particle as stored by the tree, entries being kept in the order of the cells
+*/
+template <typename TOffset>
+struct OctreeEntry {
+    TOffset x;           // Position relative to the center of the root
+    TOffset y;
+    TOffset z;
+    TOffset mass;
+    TOffset radius;
+    uint32_t index;      // Index of the particle in the arrays given to the tree
+};
+
+/**
+ * @brief How often the tree was rebuilt or only refitted
+*/
+struct OctreeStats {
+    uint64_t builds = 0;               // Full rebuilds
+    uint64_t refits = 0;               // Updates that kept the tree
+    uint64_t reinsertedParticles = 0;  // Particles that crossed the boundary of their leaf during refits
+    uint64_t leafSplits = 0;           // Leaves split during refits because particles entered them
+    uint64_t leafMerges = 0;           // Nodes turned back into leaves during refits because particles left them
+};
+
+/**
+ * @brief Barnes-Hut octree over particles stored as separate arrays
+ * @tparam T Type of the positions
+ * @tparam TOffset Type of the masses, radiuses and of the positions relative to the center of the root, used by the whole
+ *         force kernel. Taking T = double and TOffset = float keeps far away positions accurate while the kernel runs in float
+*/
+template <typename T, typename TOffset = T>
+class Octree{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param theta Opening angle of the Barnes-Hut approximation, a cell is approximated by its center of mass when size / distance < theta
+         * @param leafCapacity Maximum number of particles in a leaf
+        */
+        Octree(TOffset theta = 0.5, uint leafCapacity = 8);
+
+        /**
+         * @brief Build the tree over a set of particles stored as separate arrays
+         * @param x Array of x coordinates
+         * @param y Array of y coordinates
+         * @param z Array of z coordinates
+         * @param mass Array of masses
+         * @param radius Array of radiuses
+         * @param n The number of particles
+        */
+        void build(const T* x, const T* y, const T* z, const TOffset* mass, const TOffset* radius, size_t n);
+
+        /**
+         * @brief Bring the tree up to date with particles that moved since the last update: the moments are refitted bottom-up
+         *        and only the particles that crossed the boundary of their leaf are inserted again.
+         *        Falls back to build() when the number of particles changed, a particle left the root, the particles fill
+         *        less than half of the root, splits and merges doubled the number of nodes since the last build,
+         *        or more than 1/32 of the particles crossed a cell boundary (the next refits are then skipped for a while)
+         * @param x Array of x coordinates
+         * @param y Array of y coordinates
+         * @param z Array of z coordinates
+         * @param mass Array of masses
+         * @param radius Array of radiuses
+         * @param n The number of particles
+        */
+        void update(const T* x, const T* y, const T* z, const TOffset* mass, const TOffset* radius, size_t n);
+
+        /**
+         * @brief Remove particles from the tree, following the removal of the same particles from the arrays
+         *        (the others keeping their order), so that the next update() can still refit
+         * @param removed Array of flags, non zero for the removed particles
+         * @param n The number of particles before the removal
+        */
+        void compact(const uint8_t* removed, size_t n);
+
+        /**
+         * @brief Compute the gravitational acceleration of every particle using the Barnes-Hut approximation
+         * @param G The gravitational constant
+         * @param softening Shape of the force at short distance, applied to particles and cells alike
+         * @param ax Array receiving the x component of the accelerations
+         * @param ay Array receiving the y component of the accelerations
+         * @param az Array receiving the z component of the accelerations
+         * @param phi Array receiving the gravitational potential of every particle in the same pass, ignored if null
+         * @param begin First entry whose acceleration is computed, the entries being in the order of the cells
+         * @param end Last entry (excluded), entryCount() by default
+         * @param interactions Array receiving the number of cells and particles that acted on every particle, ignored if null
+         * @param active Only the particles of index below active get an acceleration, the others only act on them
+         * @return The number of interactions evaluated over the range
+        */
+        uint64_t computeAccelerations(double G, const Softening<TOffset>& softening, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi = nullptr,
+                                      size_t begin = 0, size_t end = SIZE_MAX, uint32_t* interactions = nullptr,
+                                      size_t active = SIZE_MAX) const;
+
+        /**
+         * @brief Call f(j) for every particle j whose sphere may reach the sphere of center (px, py, pz) and radius reach
+         * @param px The x coordinate of the center of the query sphere
+         * @param py The y coordinate of the center of the query sphere
+         * @param pz The z coordinate of the center of the query sphere
+         * @param reach The radius of the query sphere
+         * @param f The function called on each candidate index
+        */
+        template <typename F>
+        void forEachCandidate(T px, T py, T pz, TOffset reach, F f) const;
+
+        /**
+         * @brief Call f(j) for every particle j whose sphere may overlap the column [xmin, xmax] x [ymin, ymax] along z.
+         *        The particles of a cell entirely inside the column are given without testing them
+         * @param xmin The smallest x coordinate of the column
+         * @param xmax The largest x coordinate of the column
+         * @param ymin The smallest y coordinate of the column
+         * @param ymax The largest y coordinate of the column
+         * @param f The function called on each candidate index
+        */
+        template <typename F>
+        void forEachInColumn(T xmin, T xmax, T ymin, T ymax, F f) const;
+
+        /**
+         * @brief Describe the tree as seen from a box, for a force loop running elsewhere on the particles of the box.
+         *        Cells that no point of the box would open are given as single bodies, cell(mass, x, y, z), and the
+         *        particles of the leaves some point of the box may reach are given as such, particle(j)
+         * @param lo The smallest corner of the box
+         * @param hi The largest corner of the box
+         * @param cell The function called on each cell taken as a whole, with its mass and its center of mass
+         * @param particle The function called on the index of each particle given alone
+        */
+        template <typename F, typename G>
+        void forEachSummary(const T lo[3], const T hi[3], F cell, G particle) const;
+
+        /**
+         * @brief Number of nodes of the tree
+        */
+        size_t nodeCount() const;
+
+        /**
+         * @brief Number of particles in the tree
+        */
+        size_t entryCount() const;
+
+        /**
+         * @brief Cut the entries into ranges of the same total cost. The entries being in the order of the cells, each
+         *        range is a piece of the Morton curve through the octants, a compact region of space
+         * @param cost Array of the cost of every particle, by index, a particle costing at least 1
+         * @param parts Number of ranges
+         * @param bounds Receives the parts + 1 bounds of the ranges, the first one 0 and the last one entryCount()
+        */
+        void partitionEntries(const uint32_t* cost, uint parts, std::vector<size_t>& bounds) const;
+
+        /**
+         * @brief Place the entries on the NUMA nodes of the workers that compute their accelerations: the entries
+         *        allocated from now on are first written by the owners of their ranges
+         * @param pool The workers, none if null
+        */
+        void setWorkerPool(WorkerPool* pool);
+
+        /**
+         * @brief Counters of rebuilds and refits since the creation of the tree
+        */
+        const OctreeStats& stats() const;
+
+    private:
+        /**
+         * @brief Split a node into 8 children if it holds too many particles, then compute its mass moments
+         * @param node Index of the node to build
+         * @param depth Depth of the node in the tree
+        */
+        void buildNode(uint32_t node, uint depth);
+
+        /**
+         * @brief Compute the moments of a leaf from its particles
+         * @param node Index of the leaf
+        */
+        void computeLeafMoments(uint32_t node);
+
+        /**
+         * @brief Refit the moments of a subtree and collect the particles that left their leaf
+         * @param node Index of the node to refit
+         * @param lo Lower bounds of the cell, the planes used to sort the particles into it
+         * @param hi Upper bounds of the cell
+         * @return Whether a particle left a leaf of the subtree
+        */
+        bool refitNode(uint32_t node, const TOffset lo[3], const TOffset hi[3]);
+
+        /**
+         * @brief Find the leaf whose cell holds a particle, marking the nodes on the way as changed
+         * @param entry The particle
+        */
+        uint32_t findInsertionLeaf(const OctreeEntry<TOffset>& entry);
+
+        /**
+         * @brief Move the entry ranges of a subtree
+         * @param node Index of the root of the subtree
+         * @param shift Number of positions to add, modulo 2^32
+        */
+        void shiftRanges(uint32_t node, uint32_t shift);
+
+        /**
+         * @brief Lay the entries of a subtree out again, without the particles that left their leaf and with the ones
+         *        that entered it, splitting the leaves that became too full and merging the nodes that became almost empty
+         * @param node Index of the node
+         * @param depth Depth of the node in the tree
+         * @param cursor Position of the next entry
+        */
+        void relayoutNode(uint32_t node, uint depth, uint32_t& cursor);
+
+        /**
+         * @brief Compute the moments of an internal node from those of its children
+         * @param node Index of the node
+        */
+        void gatherChildren(uint32_t node);
+
+        /**
+         * @brief Force loop of computeAccelerations(), instantiated once per softening kernel
+         * @tparam K The softening kernel, the same as softening.kernel()
+         * @tparam POTENTIAL Whether the potentials are computed too
+         * @param g The gravitational constant
+         * @param softening Shape of the force at short distance
+         * @param ax Array receiving the x component of the accelerations
+         * @param ay Array receiving the y component of the accelerations
+         * @param az Array receiving the z component of the accelerations
+         * @param phi Array receiving the potentials
+         * @param begin First entry
+         * @param end Last entry (excluded)
+         * @param interactions Array receiving the number of interactions of every particle, ignored if null
+         * @param active Index of the first particle that only acts on the others
+         * @return The number of interactions evaluated
+        */
+        template <SofteningKernel K, bool POTENTIAL>
+        uint64_t accumulateAccelerations(TOffset g, const Softening<TOffset>& softening, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi,
+                                         uint32_t begin, uint32_t end, uint32_t* interactions, size_t active) const;
+
+        /**
+         * @brief Resize an array of entries, its new pages being first written by the workers if there are some
+         * @param entries The array
+         * @param n The new number of entries
+        */
+        void resizeEntries(BlockArray<OctreeEntry<TOffset>>& entries, size_t n);
+
+        std::vector<OctreeNode<TOffset>> _nodes;
+        BlockArray<OctreeEntry<TOffset>> _entries;         // Particles, grouped by cell
+        BlockArray<OctreeEntry<TOffset>> _scratchEntries;  // Buffer used to partition the entries
+        T _origin[3];                    // Center of the root, the tree works on positions relative to it
+        TOffset _theta;
+        uint _leafCapacity;
+        OctreeStats _stats;
+        WorkerPool* _pool;               // Workers placing the entries, none if null
+
+        // Refit state
+        size_t _builtNodes;              // Number of nodes after the last build
+        uint _refitBackoff;              // Number of refits skipped after the last refit abandoned for too many crossings
+        uint _skippedRefits;             // Number of updates left that build without trying to refit
+        std::vector<uint8_t> _moved;     // Whether an entry left its leaf during the current update
+        std::vector<uint8_t> _dirty;     // Whether particles left or entered a node during the current update
+        std::vector<uint32_t> _escaped;  // Entries that left their leaf during the current update
+        std::vector<uint32_t> _targets;      // New leaf of each escaped entry
+        std::vector<uint32_t> _insertStart;  // First position of the entries entering each leaf in _inserted
+        std::vector<uint32_t> _inserted;     // Escaped entries, grouped by new leaf
+        BlockArray<OctreeEntry<TOffset>> _oldEntries;
+        std::vector<uint32_t> _remap;        // Buffers used by compact()
+        std::vector<uint32_t> _positions;
+
+        static const uint MAX_DEPTH;
+        static const double MIN_FILL;    // Smallest ratio between the extent of the particles and the root before a rebuild
+        static const double ROOT_MARGIN; // Room added around the particles when building the root
+        static const double MAX_GROWTH;  // Largest ratio between the current and the built numbers of nodes before a rebuild
+        static const double MAX_REINSERTED;  // Largest fraction of the particles inserted again by a refit
+        static const uint MAX_REFIT_BACKOFF;  // Largest number of refits skipped in a row
+};
+
+template <typename T, typename TOffset>
+template <typename F>
+void Octree<T, TOffset>::forEachCandidate(T px, T py, T pz, TOffset reach, F f) const{
+    if (_nodes.empty()){
+        return;
+    }
+
+    TOffset qx = px - _origin[0];
+    TOffset qy = py - _origin[1];
+    TOffset qz = pz - _origin[2];
+
+    uint32_t stack[8 * 64];
+    uint stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0){
+        const OctreeNode<TOffset>& node = _nodes[stack[--stack_size]];
+        if (node.begin == node.end){
+            continue;
+        }
+
+        // Reject the cell if the query sphere cannot touch any sphere inside of it
+        TOffset margin = node.halfSize + reach + node.maxRadius;
+        if (qx < node.center[0] - margin || qx > node.center[0] + margin ||
+            qy < node.center[1] - margin || qy > node.center[1] + margin ||
+            qz < node.center[2] - margin || qz > node.center[2] + margin){
+            continue;
+        }
+
+        if (node.firstChild == 0){
+            for (uint32_t k = node.begin; k < node.end; k++){
+                f(_entries[k].index);
+            }
+        }
+        else {
+            for (uint32_t c = 0; c < 8; c++){
+                stack[stack_size++] = node.firstChild + c;
+            }
+        }
+    }
+}
+
+template <typename T, typename TOffset>
+template <typename F>
+void Octree<T, TOffset>::forEachInColumn(T xmin, T xmax, T ymin, T ymax, F f) const{
+    if (_nodes.empty()){
+        return;
+    }
+
+    TOffset lo[2] = {(TOffset) (xmin - _origin[0]), (TOffset) (ymin - _origin[1])};
+    TOffset hi[2] = {(TOffset) (xmax - _origin[0]), (TOffset) (ymax - _origin[1])};
+
+    uint32_t stack[8 * 64];
+    uint stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0){
+        const OctreeNode<TOffset>& node = _nodes[stack[--stack_size]];
+        if (node.begin == node.end){
+            continue;
+        }
+
+        // Footprint of the cell, grown by its biggest particle
+        TOffset margin = node.halfSize + node.maxRadius;
+        if (node.center[0] + margin < lo[0] || node.center[0] - margin > hi[0] ||
+            node.center[1] + margin < lo[1] || node.center[1] - margin > hi[1]){
+            continue;
+        }
+
+        bool inside = node.center[0] - margin >= lo[0] && node.center[0] + margin <= hi[0] &&
+                      node.center[1] - margin >= lo[1] && node.center[1] + margin <= hi[1];
+        if (inside || node.firstChild == 0){
+            for (uint32_t k = node.begin; k < node.end; k++){
+                f(_entries[k].index);
+            }
+        }
+        else {
+            for (uint32_t c = 0; c < 8; c++){
+                stack[stack_size++] = node.firstChild + c;
+            }
+        }
+    }
+}
+
+template <typename T, typename TOffset>
+template <typename F, typename G>
+void Octree<T, TOffset>::forEachSummary(const T lo[3], const T hi[3], F cell, G particle) const{
+    if (_nodes.empty()){
+        return;
+    }
+
+    TOffset box_lo[3];
+    TOffset box_hi[3];
+    for (int a = 0; a < 3; a++){
+        box_lo[a] = lo[a] - _origin[a];
+        box_hi[a] = hi[a] - _origin[a];
+    }
+    const TOffset theta2 = _theta * _theta;
+
+    uint32_t stack[8 * 64];
+    uint stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0){
+        const OctreeNode<TOffset>& node = _nodes[stack[--stack_size]];
+        if (node.begin == node.end){
+            continue;
+        }
+
+        if (node.firstChild == 0){
+            for (uint32_t k = node.begin; k < node.end; k++){
+                particle(_entries[k].index);
+            }
+            continue;
+        }
+
+        // The force loop takes the cell as a whole from any point at least as far as the nearest point of the box
+        TOffset d2 = 0;
+        for (int a = 0; a < 3; a++){
+            TOffset d = std::max<TOffset>(0, std::max(box_lo[a] - node.com[a], node.com[a] - box_hi[a]));
+            d2 += d * d;
+        }
+        TOffset size = 2 * node.halfSize;
+        if (size * size < theta2 * d2){
+            cell(node.mass, node.com[0] + _origin[0], node.com[1] + _origin[1], node.com[2] + _origin[2]);
+        }
+        else {
+            for (uint32_t c = 0; c < 8; c++){
+                stack[stack_size++] = node.firstChild + c;
+            }
+        }
+    }
+}
+
+#endif
@@ -18,6 +18,8 @@ Created: 24/02/2024
 
 #include <c3ga/Mvec.hpp>
 #include "c3gaTools.hpp"
+#include "CounterRng.hpp"
+#include "Softening.hpp"
 
 template <typename T>
 struct Vector {
@@ -72,8 +74,9 @@ class Particle{
          * @param radius The radius of the particles to create
          * @param w_width The width of the window
          * @param w_height The height of the window
+         * @param seed Seed of the random generator, the same seed gives the same set
         */
-        static std::vector<Particle> createParticleSet(uint nb, float radius, uint w_width, uint w_height);
+        static std::vector<Particle> createParticleSet(uint64_t nb, float radius, uint w_width, uint w_height, uint64_t seed);
 
         /**
          * @brief Update the position of all particles contained in the vector
@@ -81,13 +84,20 @@ class Particle{
         */
         static void updateParticlesPosition(std::vector<Particle>& particles);
 
-        static double computeGravitationalForce(Particle& p1, Particle& p2);
+        /**
+         * @brief Compute the gravitational force between two particle using Newton's equation for universal gravitation
+         * @param p1 Reference to the first particle
+         * @param p2 Reference to the second particle
+         * @param softening Shape of the force at short distance
+        */
+        static double computeGravitationalForce(Particle& p1, Particle& p2, const Softening<double>& softening);
 
         /**
          * @brief Apply the gravity of all the particle on all other particles
          * @param particles Reference to a vector of particle
+         * @param softening Shape of the force at short distance, the plain inverse square law by default
         */
-        static void applyGravity(std::vector<Particle>& particles);
+        static void applyGravity(std::vector<Particle>& particles, const Softening<double>& softening = Softening<double>(SOFTENING_NONE, 0));
 
         /**
          * @brief Apply the collision of all the particle on all other particles
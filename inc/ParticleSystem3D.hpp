@@ -0,0 +1,431 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __PARTICLE_SYSTEM_3D__
+#define __PARTICLE_SYSTEM_3D__
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+#include <c3ga/Mvec.hpp>
+#include "c3gaTools.hpp"
+#include "Octree.hpp"
+#include "BlockArray.hpp"
+#include "WorkerPool.hpp"
+#include "DomainDecomposition.hpp"
+#include "RadixSort.hpp"
+#include "Softening.hpp"
+#include "ConservationLog.hpp"
+#include "DualSphereSet.hpp"
+#include "CounterRng.hpp"
+
+/**
+ * @brief Initial distributions of the particles around the black hole
+*/
+enum SceneDistribution {
+    SCENE_UNIFORM_BOX,        // Uniform in a box, circular velocities around the z axis of the black hole
+    SCENE_EXPONENTIAL_DISC,   // Surface density in exp(-R / scaleLength) in the xy plane, circular velocities
+    SCENE_PLUMMER_SPHERE      // Plummer sphere of radius scaleLength in equilibrium, isotropic velocities
+};
+
+/**
+ * @brief Description of an initial scene
+*/
+struct SceneParameters {
+    SceneDistribution distribution = SCENE_UNIFORM_BOX;
+    uint64_t nbParticles = 300;         // Number of particles, without the black hole
+    double radius = 10;                 // Radius of the particles
+    double center[3] = {0, 0, 0};       // Position of the black hole
+    double halfSize[3] = {1, 1, 1};     // Half extents of the box
+    double scaleLength = 300;           // Scale length of the disc, radius of the Plummer sphere
+    double scaleHeight = 20;            // Scale height of the disc
+    uint64_t seed = 0;                  // Seed of the random generator, the same seed gives the same scene
+    uint nbThreads = 0;                 // Number of threads filling the set, 0 for one per hardware thread
+};
+
+/**
+ * @brief How evenly the workers shared the force loop
+*/
+struct BalanceStats {
+    uint64_t steps = 0;                         // Force loops run on the workers
+    uint64_t rebalances = 0;                    // Partitions cut again from the costs of the particles
+    double lastImbalance = 1;                   // CPU time of the slowest worker over the average, during the last step
+    double imbalanceSum = 0;                    // Sum of the imbalances of the steps
+    std::vector<double> workerSeconds;          // CPU time spent by each worker in the force loop, over all the steps
+    std::vector<uint64_t> workerInteractions;   // Interactions evaluated by each worker, over all the steps
+};
+
+/**
+ * @brief How the gravity is integrated
+*/
+struct GravityParameters {
+    SofteningKernel kernel = SOFTENING_PLUMMER;  // Shape of the force at short distance
+    double softening = 1;               // Softening length, in pixels
+    double regularization = 0;          // Mutual nearest neighbours closer than this (in pixels) are moved along their two-body
+                                        // orbit with substeps of their own, 0 to disable
+    double dt = 1;                      // Time step, one step per frame
+    bool sweptCollisions = false;       // Whether the contacts are searched along the whole move of the particles
+                                        // during the step, instead of only at their new positions
+};
+
+/**
+ * @brief Set of particles moving in 3D, stored as one array per component (structure of arrays).
+ *        c3ga is only used when building the scene and for the sphere-sphere contact test,
+ *        the gravity runs on plain scalars through an octree.
+ * @tparam T Type of the positions
+ * @tparam TOffset Type of the velocities, accelerations and radiuses, and of the offsets between positions in the force kernel
+*/
+template <typename T, typename TOffset = T>
+class ParticleSystem3D{
+    public:
+
+        /**
+         * @brief Create a set of particles with random positions around the fixed black hole,
+         *        including nb particles + the center fixed black hole
+         * @param nb The number of particles to create
+         * @param radius The radius of the particles to create
+         * @param w_width The width of the window
+         * @param w_height The height of the window
+         * @param seed Seed of the random generator, the same seed gives the same set
+        */
+        static ParticleSystem3D createParticleSet(uint64_t nb, TOffset radius, uint w_width, uint w_height, uint64_t seed);
+
+        /**
+         * @brief Create a scene: the fixed black hole at index 0, then the particles.
+         *        The arrays are allocated once and filled by chunks in parallel, particle i drawing from the random stream i
+         *        so that the scene does not depend on the number of threads
+         * @param parameters Description of the scene
+         * @param pool Workers filling the set, each one writing first the particles it owns, and kept by the set
+         *        (see setWorkerPool()). If null, the set is filled by parameters.nbThreads threads
+        */
+        static ParticleSystem3D createScene(const SceneParameters& parameters, WorkerPool* pool = nullptr);
+
+        /**
+         * @brief Change the number of particles, new particles are at the origin with a null radius and get new identifiers
+         * @param n The new number of particles
+        */
+        void resize(size_t n);
+
+        /**
+         * @brief Copy the positions, velocities, radiuses and fixed flags into another set, such as a snapshot read by
+         *        another thread. The arrays are copied by ranges on the workers of this set
+         * @param snapshot The set receiving the copy, resized to this one
+        */
+        void copyState(ParticleSystem3D& snapshot);
+
+        /**
+         * @brief Reorder the particles, the particle k of the new order being the particle order[k] of the current one.
+         *        The arrays are gathered in parallel on the workers, and the octree is built again
+         * @param order A permutation of the indices of the particles
+        */
+        void permute(const uint32_t* order);
+
+        /**
+         * @brief Reorder the particles along a Morton curve through their bounding box, so that particles close in space
+         *        are close in the arrays. The black hole stays first
+        */
+        void sortSpatially();
+
+        /**
+         * @brief Sort the particles spatially before the gravity, every k steps
+         * @param k Number of steps between two sorts, 0 to keep the order
+        */
+        void setSortPeriod(uint k);
+
+        /**
+         * @brief Overwrite a particle of the set
+         * @param i Index of the particle
+         * @param x The x coordinate of the position
+         * @param y The y coordinate of the position
+         * @param z The z coordinate of the position
+         * @param radius Radius of the particle (in pixels), also used as its mass
+         * @param vx The x component of the velocity
+         * @param vy The y component of the velocity
+         * @param vz The z component of the velocity
+         * @param fixed Whether the particle is fixed or not
+        */
+        void setParticle(size_t i, T x, T y, T z, TOffset radius, TOffset vx, TOffset vy, TOffset vz, bool fixed = false);
+
+        /**
+         * @brief Add a particle to the set
+         * @param point Conformal point (c3ga) giving the position of the particle
+         * @param radius Radius of the particle (in pixels), also used as its mass
+         * @param vx The x component of the velocity
+         * @param vy The y component of the velocity
+         * @param vz The z component of the velocity
+         * @param fixed Whether the particle is fixed or not
+        */
+        void addParticle(const c3ga::Mvec<double>& point, TOffset radius, TOffset vx, TOffset vy, TOffset vz, bool fixed = false);
+
+        /**
+         * @brief Number of particles in the set
+        */
+        size_t size() const;
+
+        /**
+         * @brief Position accessors
+        */
+        T getX(size_t i) const;
+        T getY(size_t i) const;
+        T getZ(size_t i) const;
+
+        /**
+         * @brief Velocity accessors
+        */
+        TOffset getVX(size_t i) const;
+        TOffset getVY(size_t i) const;
+        TOffset getVZ(size_t i) const;
+
+        /**
+         * @brief Radius accessor
+        */
+        TOffset getRadius(size_t i) const;
+
+        /**
+         * @brief Identifier of a particle, it never changes and increases with the index
+         * @param i Index of the particle
+        */
+        uint64_t getId(size_t i) const;
+
+        /**
+         * @brief Build the dual sphere (c3ga) of a particle: s = center - 0.5 radius^2 ei
+         * @param i Index of the particle
+        */
+        c3ga::Mvec<double> getDualSphere(size_t i) const;
+
+        /**
+         * @brief Check whether two particles are in contact, using the inner product of their dual spheres
+         * @param i Index of the first particle
+         * @param j Index of the second particle
+        */
+        bool isInContact(size_t i, size_t j) const;
+
+        /**
+         * @brief Call f(i) for every particle i whose sphere may overlap the column [xmin, xmax] x [ymin, ymax] along z,
+         *        through the octree, brought up to date first if the particles moved since its last update
+         * @param xmin The smallest x coordinate of the column
+         * @param xmax The largest x coordinate of the column
+         * @param ymin The smallest y coordinate of the column
+         * @param ymax The largest y coordinate of the column
+         * @param f The function called on each index
+        */
+        template <typename F>
+        void forEachInColumn(T xmin, T xmax, T ymin, T ymax, F f);
+
+        /**
+         * @brief Counters of rebuilds and refits of the octree
+        */
+        const OctreeStats& getTreeStats() const;
+
+        /**
+         * @brief Change how the gravity is integrated
+         * @param parameters The softening, regularization and time step
+        */
+        void setGravity(const GravityParameters& parameters);
+
+        /**
+         * @brief How the gravity is integrated
+        */
+        const GravityParameters& getGravity() const;
+
+        /**
+         * @brief Run the force loop and the kicks on a pool of workers, each one always handling the same range of
+         *        octree entries and of particles. The arrays allocated from now on are first written by the workers
+         *        owning their ranges, so that these ranges are on the NUMA node of their workers
+         * @param pool The workers, the calling thread doing everything if null. It must outlive the set
+        */
+        void setWorkerPool(WorkerPool* pool);
+
+        /**
+         * @brief Compute the gravity on worker processes, one per spatial domain, instead of in this process
+         * @param domains The running workers, none if null. If they stop, the gravity goes back to this process
+        */
+        void setDomains(DomainDecomposition<T, TOffset>* domains);
+
+        /**
+         * @brief Share the force loop between the workers by cost instead of by number of particles: every k steps,
+         *        the octree entries are cut into ranges of the same number of interactions, as counted for each
+         *        particle during the previous step
+         * @param k Number of steps between two partitions, 0 for the fixed ranges owned by the workers
+        */
+        void setBalancePeriod(uint k);
+
+        /**
+         * @brief How evenly the workers shared the force loop
+        */
+        const BalanceStats& getBalanceStats() const;
+
+        /**
+         * @brief Number of pairs integrated as two-body orbits during the last step
+        */
+        size_t getRegularizedPairs() const;
+
+        /**
+         * @brief Compute the acceleration of all particles with the Barnes-Hut octree and update their velocities
+         * @param diagnostics If not null, receives the conserved quantities before the step, the potential energy
+         *        coming from the same tree walk as the accelerations
+        */
+        void applyGravity(ConservationSample* diagnostics = nullptr);
+
+        /**
+         * @brief Move all the non fixed particles according to their velocity
+        */
+        void updateParticlesPosition();
+
+        /**
+         * @brief Merge all the particles in contact, the octree provides the candidate pairs
+         *        and the dual spheres decide which of them are in contact, all at once.
+         *        The particles reaching a fixed body are first absorbed by it, the fixed bodies staying out of the pair search.
+         *        With swept collisions, the particles are spheres moving in straight lines over the last move, and the
+         *        pairs that touch at some time of the step merge in the order of their first contact
+        */
+        void applyCollision();
+
+    private:
+        /**
+         * @brief Remove the particles marked in _toRemove, keeping the order of the others
+        */
+        void removeMarkedParticles();
+
+        /**
+         * @brief List the fixed particles in _fixedBodies, if they may have changed since the last time
+        */
+        void findFixedBodies();
+
+        /**
+         * @brief Merge into the fixed bodies the particles that reach them, with a distance check of every particle
+         *        against every fixed body over the arrays
+         * @param swept Whether the particles are checked along their whole move, _startX holding the middles of the moves
+        */
+        void applyAccretion(bool swept);
+
+        /**
+         * @brief Narrow phase of the swept collisions: find the candidate pairs whose spheres touch during the last move,
+         *        and sort them by time of first contact into _contacts
+        */
+        void findSweptContacts();
+
+        /**
+         * @brief Sum the conserved quantities over the set, in parallel. The velocities are moved half a kick forward
+         *        so that they are at the same time as the positions
+         * @param sample Receives the sums
+        */
+        void measureConservation(ConservationSample& sample);
+
+        /**
+         * @brief Find the mutual nearest neighbours closer than the regularization radius,
+         *        and take their mutual force out of their accelerations
+        */
+        void findRegularizedPairs();
+
+        /**
+         * @brief Move a regularized pair over a step: its center of mass drifts, and the two particles follow their
+         *        two-body orbit around it with substeps short against the orbital time
+         * @param i Index of the first particle
+         * @param j Index of the second particle
+        */
+        void moveRegularizedPair(size_t i, size_t j);
+
+        /**
+         * @brief Call f(begin, end) on the range of [0, n[ owned by each worker of the pool, or on [0, n[ without a pool
+         * @param n The number of items
+         * @param f The function called on each range
+        */
+        template <typename F>
+        void forEachOwnedRange(size_t n, F f);
+
+        /**
+         * @brief Compute the accelerations on the octree, on the workers if there are some, counting the interactions
+         *        of every particle and cutting the entries again by cost when a partition is due
+         * @param phi Array receiving the potentials, ignored if null
+        */
+        void computeBalancedAccelerations(TOffset* phi);
+
+        BlockArray<T> _x;
+        BlockArray<T> _y;
+        BlockArray<T> _z;
+        BlockArray<TOffset> _vx;
+        BlockArray<TOffset> _vy;
+        BlockArray<TOffset> _vz;
+        BlockArray<TOffset> _ax;
+        BlockArray<TOffset> _ay;
+        BlockArray<TOffset> _az;
+        BlockArray<TOffset> _phi;        // Gravitational potential, only filled on the steps that are measured
+        BlockArray<TOffset> _radius;
+        BlockArray<uint8_t> _fixed;      // Whether the particle can move or not
+        BlockArray<uint8_t> _toRemove;   // Whether the particle has been merged into another one
+        BlockArray<uint64_t> _id;        // Identifier, kept when the particles before it are removed
+        BlockArray<uint32_t> _cost;      // Interactions evaluated for the particle during the last force loop
+        uint64_t _nextId = 0;            // Identifier given to the next particle added
+
+        Octree<T, TOffset> _octree;
+        bool _treeCurrent = false;       // Whether the octree holds the current positions and radiuses
+        GravityParameters _gravity;
+        Softening<TOffset> _softening;
+        WorkerPool* _pool = nullptr;     // Workers of the force loop, none if null
+        DomainDecomposition<T, TOffset>* _domains = nullptr;  // Worker processes computing the gravity, none if null
+
+        // Partition of the force loop between the workers
+        uint _balancePeriod = 0;
+        uint64_t _balancedAt = 0;        // Step of the last partition
+        std::vector<size_t> _partition;  // Bounds of the range of octree entries of each worker
+        std::vector<double> _stepSeconds;
+        std::vector<uint64_t> _stepInteractions;
+        BalanceStats _balance;
+
+        // Spatial sort
+        uint _sortPeriod = 0;
+        uint64_t _gravitySteps = 0;
+        RadixSorter<uint64_t> _sorter;
+        std::vector<uint64_t> _sortKeys;   // Morton code of each particle after the black hole
+        std::vector<uint32_t> _sortOrder;
+
+        // Regularized pairs of the current step
+        std::vector<uint32_t> _nearest;     // Nearest neighbour within the regularization radius
+        std::vector<uint32_t> _regularizedFirst;
+        std::vector<uint32_t> _regularizedSecond;
+        std::vector<uint8_t> _regularized;  // Whether the particle is moved with its pair
+
+        // Collision buffers, kept between steps to avoid reallocations
+        Octree<T, TOffset> _contactTree;    // Tree of the pair search, over the middles of the moves when swept
+        BlockArray<TOffset> _contactReach;  // Radius of each particle in the pair search, grown by half its move when swept, 0 if fixed
+        DualSphereSet<TOffset> _spheres;
+        std::vector<uint32_t> _pairFirst;
+        std::vector<uint32_t> _pairSecond;
+        std::vector<uint8_t> _pairContact;
+        std::vector<uint32_t> _contacts;    // Pairs in contact, in the order they merge
+        std::vector<uint32_t> _fixedBodies; // Indices of the fixed particles, kept out of the pair search
+        bool _fixedCurrent = false;         // Whether _fixedBodies lists the current fixed particles
+        std::vector<uint32_t> _accretedBy;  // Position in _fixedBodies plus one of the body a particle falls into, 0 for none
+        std::vector<uint64_t> _contactTimes;
+
+        // Positions before the last move, kept for the swept collisions, which turn them into the middles of the moves
+        BlockArray<T> _startX;
+        BlockArray<T> _startY;
+        BlockArray<T> _startZ;
+        bool _startCurrent = false;         // Whether the start positions are those of the last move
+
+        // Diagnostics
+        std::vector<double> _partialSums;
+
+        static const double G;
+        static const TOffset BH_RADIUS;
+        static const double PAIR_ACCURACY;  // Substep of a regularized pair, as a fraction of its orbital time sqrt(d^3 / G M)
+        static const uint MAX_PAIR_SUBSTEPS;
+};
+
+template <typename T, typename TOffset>
+template <typename F>
+void ParticleSystem3D<T, TOffset>::forEachInColumn(T xmin, T xmax, T ymin, T ymax, F f){
+    if (!_treeCurrent){
+        _octree.update(_x.data(), _y.data(), _z.data(), _radius.data(), _radius.data(), size());
+        _treeCurrent = true;
+    }
+    _octree.forEachInColumn(xmin, xmax, ymin, ymax, f);
+}
+
+#endif
@@ -0,0 +1,121 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __RADIX_SORT__
+#define __RADIX_SORT__
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+#include "BlockArray.hpp"
+#include "WorkerPool.hpp"
+
+/**
+ * @brief Least significant digit radix sort of unsigned keys, each one carrying an index, in parallel on a pool of workers.
+ *        The keys are sorted digit by digit, the digits of up to 11 bits being spread evenly over the bits of the keys
+ *        (11 + 11 + 10 bits for 32 bit keys). Each pass counts the digits of the range owned by each worker, then each
+ *        worker moves its keys to the positions that follow the keys of the smaller digits and of the previous workers,
+ *        so the sort is stable. A pass whose digit is the same for every key is skipped
+ * @tparam K Type of the keys, uint32_t or uint64_t
+*/
+template <typename K>
+class RadixSorter{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param pool The workers, the calling thread sorting alone if null
+        */
+        RadixSorter(WorkerPool* pool = nullptr);
+
+        /**
+         * @brief Sort key/index pairs by increasing key, pairs of equal keys keeping their order
+         * @param keys Array of keys, sorted in place
+         * @param indices Array of indices moved with their keys, ignored if null
+         * @param n The number of pairs
+         * @param keyBits Number of low bits that may be set in the keys, the other ones being ignored
+        */
+        void sort(K* keys, uint32_t* indices, size_t n, uint keyBits = 8 * sizeof(K));
+
+        /**
+         * @brief Sort on other workers
+         * @param pool The workers, the calling thread sorting alone if null
+        */
+        void setWorkerPool(WorkerPool* pool);
+
+        static const uint MAX_DIGIT_BITS;
+        static const size_t MIN_PARALLEL_KEYS;  // Smaller sorts run on the calling thread, waking the workers costing more
+
+    private:
+        /**
+         * @brief Call f(worker, begin, end) on the range of [0, n[ owned by each worker, or f(0, 0, n) if the current
+         *        sort runs on the calling thread
+         * @param n The number of items
+         * @param f The function called on each range
+        */
+        template <typename F>
+        void forEachRange(size_t n, F f);
+
+        WorkerPool* _pool;
+        bool _parallel;                  // Whether the current sort runs on the workers
+        BlockArray<K> _keys;             // Buffers the passes move the pairs to
+        BlockArray<uint32_t> _indices;
+        std::vector<size_t> _counts;     // Number of keys of each digit in the range of each worker, then where they go
+};
+
+/**
+ * @brief Gather an array through a permutation, dst[k] = src[order[k]], in parallel on a pool of workers
+ * @param dst Array receiving the items, different from src
+ * @param src Array of the items
+ * @param order Index in src of every item of dst
+ * @param n The number of items
+ * @param pool The workers, the calling thread doing everything if null
+*/
+template <typename T>
+void gatherArray(T* dst, const T* src, const uint32_t* order, size_t n, WorkerPool* pool = nullptr);
+
+/**
+ * @brief Scatter an array through a permutation, dst[order[k]] = src[k], in parallel on a pool of workers
+ * @param dst Array receiving the items, different from src
+ * @param src Array of the items
+ * @param order Index in dst of every item of src
+ * @param n The number of items
+ * @param pool The workers, the calling thread doing everything if null
+*/
+template <typename T>
+void scatterArray(T* dst, const T* src, const uint32_t* order, size_t n, WorkerPool* pool = nullptr);
+
+template <typename T>
+void gatherArray(T* dst, const T* src, const uint32_t* order, size_t n, WorkerPool* pool){
+    auto gather = [&](uint, size_t begin, size_t end){
+        for (size_t k = begin; k < end; k++){
+            dst[k] = src[order[k]];
+        }
+    };
+    if (pool == nullptr){
+        gather(0, 0, n);
+        return;
+    }
+    pool->forEachRange(n, gather);
+}
+
+template <typename T>
+void scatterArray(T* dst, const T* src, const uint32_t* order, size_t n, WorkerPool* pool){
+    auto scatter = [&](uint, size_t begin, size_t end){
+        for (size_t k = begin; k < end; k++){
+            dst[order[k]] = src[k];
+        }
+    };
+    if (pool == nullptr){
+        scatter(0, 0, n);
+        return;
+    }
+    pool->forEachRange(n, scatter);
+}
+
+#endif
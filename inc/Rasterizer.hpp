@@ -0,0 +1,145 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __RASTERIZER__
+#define __RASTERIZER__
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+#include "WorkerPool.hpp"
+
+/**
+ * @brief Software renderer of particles into an ARGB pixel buffer, to be uploaded in one texture per frame.
+ *        Each particle is an antialiased filled disc surrounded by a glow, or a single pixel if it is smaller than one,
+ *        and their colors add up.
+ *        The discs are first sorted into bins of square tiles, then the tiles are drawn in parallel, each thread
+ *        accumulating one tile at a time in a buffer that stays in its cache. The rows of a disc are drawn by
+ *        branch-free loops the compiler turns into SIMD code. The threads are started by the first render and kept
+ *        for the next ones. The result does not depend on the number of threads
+*/
+class Rasterizer{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param width Width of the pixel buffer
+         * @param height Height of the pixel buffer
+         * @param nb_threads Number of threads drawing the tiles, 0 for one per hardware thread
+        */
+        Rasterizer(uint width, uint height, uint nb_threads = 0);
+
+        /**
+         * @brief Remove the discs added since the last render
+        */
+        void clear();
+
+        /**
+         * @brief Add a disc to the next render, ignored if its glow does not reach the buffer
+         * @param x The x coordinate of the center, in pixels
+         * @param y The y coordinate of the center, in pixels
+         * @param radius The radius of the disc, in pixels
+         * @param r Red component, 1 for full intensity
+         * @param g Green component, 1 for full intensity
+         * @param b Blue component, 1 for full intensity
+        */
+        void addDisc(float x, float y, float radius, float r, float g, float b);
+
+        /**
+         * @brief Draw the discs added since the last clear() on a black background
+        */
+        void render();
+
+        /**
+         * @brief Pixels drawn by the last render, in rows of width() ARGB values
+        */
+        const uint32_t* pixels() const;
+
+        /**
+         * @brief Exchange the pixel buffer with another one, so that the last frame can be kept without copying it
+         * @param pixels A buffer of width() * height() pixels, whose content the next render overwrites entirely
+        */
+        void swapPixels(std::vector<uint32_t>& pixels);
+
+        /**
+         * @brief Width of the pixel buffer
+        */
+        uint width() const;
+
+        /**
+         * @brief Height of the pixel buffer
+        */
+        uint height() const;
+
+        /**
+         * @brief Number of discs added since the last clear()
+        */
+        size_t discCount() const;
+
+        static const int TILE_SIZE;          // Side of a tile, in pixels
+        static const float GLOW_RADIUS;      // Radius of the glow, in radiuses of the disc
+        static const float GLOW_STRENGTH;    // Intensity of the glow at the edge of the disc
+        static const float POINT_RADIUS;     // Discs smaller than this radius are added to one pixel, without glow
+        static const float POINT_INTENSITY;  // Intensity of these discs
+
+    private:
+        /**
+         * @brief Sort the discs into the bins of the tiles they touch
+        */
+        void binDiscs();
+
+        /**
+         * @brief Draw the discs of a tile and write its pixels
+         * @param tile Index of the tile, row by row
+        */
+        void renderTile(size_t tile);
+
+        /**
+         * @brief Call f(chunk, begin, end) on the chunks of [0, n[, the threads of the rasterizer taking the next chunk
+         *        when they are done
+         * @param n The number of items
+         * @param chunk_size The number of items of a chunk
+         * @param f The function called on each chunk
+        */
+        template <typename F>
+        void forEachChunk(size_t n, size_t chunk_size, F f);
+
+        /**
+         * @brief Radius beyond which a disc adds nothing
+         * @param radius The radius of the disc
+        */
+        static float reach(float radius);
+
+        static const size_t BIN_CHUNK;  // Number of discs binned by a thread at a time
+
+        uint _width;
+        uint _height;
+        uint _nbThreads;
+        std::unique_ptr<WorkerPool> _pool;  // Threads drawing the tiles, kept between renders
+        std::vector<size_t> _poolBounds;    // One item per thread, each one then taking chunks until none is left
+        uint _tilesX;
+        uint _tilesY;
+
+        struct Disc {
+            float x;
+            float y;
+            float radius;
+            float r;
+            float g;
+            float b;
+        };
+
+        std::vector<Disc> _discs;         // Discs of the next render
+        std::vector<uint32_t> _binStart;  // Discs of tile t are _binDiscs[_binStart[t]] to _binDiscs[_binStart[t + 1] - 1]
+        std::vector<Disc> _binDiscs;      // Copies of the discs, so that a tile reads its discs in a row
+        std::vector<uint32_t> _chunkOffsets;  // Where each chunk of discs copies its discs of each tile
+        std::vector<uint32_t> _pixels;
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __SOFTENING__
+#define __SOFTENING__
+
+#pragma once
+#include <cmath>
+
+/**
+ * @brief Shapes of the gravitational force at short distance
+*/
+enum SofteningKernel {
+    SOFTENING_NONE,      // Newtonian force, infinite when two centers meet (0 at exactly the same position)
+    SOFTENING_PLUMMER,   // Force of a Plummer sphere of radius eps: m d / (d^2 + eps^2)^(3/2), slightly weaker at all distances
+    SOFTENING_SPLINE     // Force of the cubic spline density used by Gadget, exactly Newtonian beyond 2.8 eps
+};
+
+/**
+ * @brief Softened gravity kernel: the acceleration given by a mass m at offset d is G m d inverseCube(|d|^2),
+ *        inverseCube being 1 / |d|^3 for the Newtonian force.
+ *        The kernel is a template parameter of inverseCube() so that force loops can be instantiated once per kernel
+ * @tparam T Type of the distances
+*/
+template <typename T>
+class Softening{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param kernel Shape of the force at short distance
+         * @param length Softening length eps, the Plummer radius, or the spline length (whose support is 2.8 eps)
+        */
+        Softening(SofteningKernel kernel = SOFTENING_PLUMMER, T length = 1);
+
+        /**
+         * @brief Shape of the force at short distance
+        */
+        SofteningKernel kernel() const;
+
+        /**
+         * @brief Softening length eps
+        */
+        T length() const;
+
+        /**
+         * @brief Softened equivalent of 1 / |d|^3
+         * @param r2 Squared distance |d|^2
+        */
+        template <SofteningKernel K>
+        T inverseCube(T r2) const;
+
+        /**
+         * @brief Softened equivalent of 1 / |d|^3, for callers outside of a loop instantiated per kernel
+         * @param r2 Squared distance |d|^2
+        */
+        T inverseCube(T r2) const;
+
+        /**
+         * @brief Softened equivalent of 1 / |d|, the potential of a mass m at distance |d| being -G m inverseDistance(|d|^2)
+         * @param r2 Squared distance |d|^2
+        */
+        template <SofteningKernel K>
+        T inverseDistance(T r2) const;
+
+    private:
+        SofteningKernel _kernel;
+        T _length;
+        T _eps2;     // Plummer: eps^2
+        T _h;        // Spline: radius of the support, 2.8 eps
+        T _invH;
+        T _invH3;
+
+        static const T SPLINE_SUPPORT;  // Ratio between the support of the spline and its Plummer-equivalent length
+};
+
+template <typename T>
+template <SofteningKernel K>
+inline T Softening<T>::inverseCube(T r2) const{
+    if (K == SOFTENING_PLUMMER){
+        T inv_r = 1 / std::sqrt(r2 + _eps2);
+        return inv_r * inv_r * inv_r;
+    }
+    if (K == SOFTENING_SPLINE && r2 < _h * _h){
+        // Gadget-2 cubic spline, with u = r / h
+        T u = std::sqrt(r2) * _invH;
+        T u2 = u * u;
+        if (u < T(0.5)){
+            return _invH3 * (T(10.666666666667) + u2 * (T(32.0) * u - T(38.4)));
+        }
+        return _invH3 * (T(21.333333333333) - T(48.0) * u + T(38.4) * u2 - T(10.666666666667) * u2 * u
+                         - T(0.066666666667) / (u2 * u));
+    }
+    if (r2 == 0){
+        return 0;
+    }
+    T inv_r = 1 / std::sqrt(r2);
+    return inv_r * inv_r * inv_r;
+}
+
+template <typename T>
+template <SofteningKernel K>
+inline T Softening<T>::inverseDistance(T r2) const{
+    if (K == SOFTENING_PLUMMER){
+        return 1 / std::sqrt(r2 + _eps2);
+    }
+    if (K == SOFTENING_SPLINE && r2 < _h * _h){
+        // Gadget-2 cubic spline, with u = r / h
+        T u = std::sqrt(r2) * _invH;
+        T u2 = u * u;
+        if (u < T(0.5)){
+            return -_invH * (T(-2.8) + u2 * (T(5.333333333333) + u2 * (T(6.4) * u - T(9.6))));
+        }
+        return -_invH * (T(-3.2) + T(0.066666666667) / u + u2 * (T(10.666666666667) + u * (T(-16.0) + u * (T(9.6) - T(2.133333333333) * u))));
+    }
+    if (r2 == 0){
+        return 0;
+    }
+    return 1 / std::sqrt(r2);
+}
+
+template <typename T>
+inline T Softening<T>::inverseCube(T r2) const{
+    switch (_kernel){
+        case SOFTENING_PLUMMER:
+            return inverseCube<SOFTENING_PLUMMER>(r2);
+        case SOFTENING_SPLINE:
+            return inverseCube<SOFTENING_SPLINE>(r2);
+        default:
+            return inverseCube<SOFTENING_NONE>(r2);
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __SPSC_QUEUE__
+#define __SPSC_QUEUE__
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Bounded lock-free queue between one producer thread and one consumer thread.
+ *        The slots are allocated once and reused: the producer fills a slot in place then publishes it,
+ *        the consumer reads it in place then releases it, so big items are never copied nor reallocated.
+ * @tparam T Type of the items
+*/
+template <typename T>
+class SpscQueue{
+    public:
+
+        /**
+         * @brief Constructor
+         * @param capacity Maximum number of items in the queue
+        */
+        SpscQueue(size_t capacity);
+
+        /**
+         * @brief Producer side: slot to fill, nullptr if the queue is full
+        */
+        T* beginPush();
+
+        /**
+         * @brief Producer side: publish the slot returned by beginPush()
+        */
+        void endPush();
+
+        /**
+         * @brief Consumer side: oldest published item, nullptr if the queue is empty
+        */
+        T* front();
+
+        /**
+         * @brief Consumer side: release the item returned by front()
+        */
+        void pop();
+
+        /**
+         * @brief Number of items published and not yet released
+        */
+        size_t size() const;
+
+        /**
+         * @brief Maximum number of items in the queue
+        */
+        size_t capacity() const;
+
+    private:
+        std::vector<T> _slots;
+        alignas(64) std::atomic<size_t> _head;  // Number of items released by the consumer
+        alignas(64) std::atomic<size_t> _tail;  // Number of items published by the producer
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity)
+    : _slots(capacity == 0 ? 1 : capacity)
+    , _head {0}
+    , _tail {0}
+    {}
+
+template <typename T>
+T* SpscQueue<T>::beginPush(){
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == _slots.size()){
+        return nullptr;
+    }
+    return &_slots[tail % _slots.size()];
+}
+
+template <typename T>
+void SpscQueue<T>::endPush(){
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T>
+T* SpscQueue<T>::front(){
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire)){
+        return nullptr;
+    }
+    return &_slots[head % _slots.size()];
+}
+
+template <typename T>
+void SpscQueue<T>::pop(){
+    _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T>
+size_t SpscQueue<T>::size() const{
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t SpscQueue<T>::capacity() const{
+    return _slots.size();
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __TRAJECTORY_FORMAT__
+#define __TRAJECTORY_FORMAT__
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+Layout of a trajectory file (native endianness):
+
+    TrajectoryHeader
+    frame 0: TrajectoryFrameHeader, then payloadSize bytes
+    frame 1: ...
+    TrajectoryIndexEntry x nbFrames
+    TrajectoryTrailer
+
+The payload of a frame holds the identifiers (ascending) as varint deltas, then each field of the
+header field mask, one after the other. A field value is quantized to an integer number of quantums,
+and stored as the zigzag varint of its difference with the value of the same particle in the previous
+frame. Keyframes, and particles missing from the previous frame, take 0 as previous value.
+A chunk is a keyframe and the delta frames up to the next keyframe: decoding a frame only needs
+its chunk. If the writer did not close the file, the index can be rebuilt by walking the frame headers.
+*/
+
+/**
+ * @brief Fields that can be stored for each particle
+*/
+enum TrajectoryField {
+    TRAJ_X,
+    TRAJ_Y,
+    TRAJ_Z,
+    TRAJ_RADIUS,
+    TRAJ_VX,
+    TRAJ_VY,
+    TRAJ_VZ,
+    TRAJ_FIELD_COUNT
+};
+
+static const char TRAJECTORY_MAGIC[8] = {'G', 'S', 'T', 'R', 'A', 'J', '1', '\n'};
+static const char TRAJECTORY_INDEX_MAGIC[8] = {'G', 'S', 'I', 'N', 'D', 'E', 'X', '\n'};
+static const uint32_t TRAJECTORY_FRAME_MAGIC = 0x52464753;  // "GSFR"
+static const uint32_t TRAJECTORY_VERSION = 1;
+static const uint32_t TRAJECTORY_KEYFRAME = 1;  // Frame flag
+
+struct TrajectoryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t fieldMask;                    // Bit f set if the field f is stored
+    double quantum[TRAJ_FIELD_COUNT];      // Quantization step of each field
+    uint32_t keyframeInterval;             // Number of frames in a chunk
+    uint32_t sampleEvery;                  // Number of simulation steps between two frames
+};
+
+struct TrajectoryFrameHeader {
+    uint32_t magic;
+    uint32_t flags;
+    uint64_t step;                         // Simulation step of the frame
+    uint32_t nbParticles;
+    uint32_t payloadSize;                  // Size of the payload following the header, in bytes
+};
+
+struct TrajectoryIndexEntry {
+    uint64_t offset;                       // Position of the frame header in the file
+    uint64_t step;
+    uint32_t nbParticles;
+    uint32_t flags;
+};
+
+struct TrajectoryTrailer {
+    uint64_t indexOffset;                  // Position of the first index entry in the file
+    uint64_t nbFrames;
+    char magic[8];
+};
+
+/**
+ * @brief Append an unsigned integer as a varint (7 bits per byte, high bit set when more bytes follow)
+ * @param out The buffer to append to
+ * @param value The value to write
+*/
+inline void writeVarint(std::vector<uint8_t>& out, uint64_t value){
+    while (value >= 0x80){
+        out.push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t) value);
+}
+
+/**
+ * @brief Read a varint
+ * @param data Position to read from, moved after the varint
+ * @param end End of the buffer
+ * @param value Receives the value
+ * @return false if the buffer ends before the varint
+*/
+inline bool readVarint(const uint8_t*& data, const uint8_t* end, uint64_t& value){
+    value = 0;
+    for (int shift = 0; shift < 64 && data < end; shift += 7){
+        uint8_t byte = *data++;
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)){
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Map signed integers to unsigned ones, small magnitudes giving small values
+*/
+inline uint64_t zigzagEncode(int64_t value){
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value){
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __TRAJECTORY_READER__
+#define __TRAJECTORY_READER__
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "ParticleSystem3D.hpp"
+#include "TrajectoryFormat.hpp"
+
+/**
+ * @brief Reads trajectory files (see TrajectoryFormat.hpp) through a memory mapping.
+ *        Frames can be read in any order: the last decoded frame is kept, so reading the next one only decodes
+ *        its deltas, while any other frame is decoded from the keyframe of its chunk.
+*/
+class TrajectoryReader{
+    public:
+
+        /**
+         * @brief Constructor, nothing is read until open() is called
+        */
+        TrajectoryReader();
+
+        /**
+         * @brief Destructor, unmaps the file
+        */
+        ~TrajectoryReader();
+
+        /**
+         * @brief Map a trajectory file and load its index, rebuilt from the frames if the file was not closed
+         * @param path Path of the file
+         * @return false if the file cannot be read or is not a trajectory
+        */
+        bool open(const char* path);
+
+        /**
+         * @brief Unmap the file
+        */
+        void close();
+
+        /**
+         * @brief Number of frames of the file
+        */
+        size_t frameCount() const;
+
+        /**
+         * @brief Simulation step of a frame
+         * @param frame Index of the frame
+        */
+        uint64_t frameStep(size_t frame) const;
+
+        /**
+         * @brief Decode a frame into a set of particles, the black hole (identifier 0) being fixed
+         * @param frame Index of the frame
+         * @param particles Receives the particles of the frame
+         * @return false if the frame is out of range or corrupted
+        */
+        template <typename T, typename TOffset>
+        bool readFrame(size_t frame, ParticleSystem3D<T, TOffset>& particles);
+
+    private:
+        /**
+         * @brief Decode the frame following the last decoded one (or the given keyframe)
+         * @param frame Index of the frame
+         * @return false if the frame is corrupted
+        */
+        bool decodeFrame(size_t frame);
+
+        /**
+         * @brief Rebuild the index by walking the frame headers, for files whose writer did not close them
+        */
+        void rebuildIndex();
+
+        int _fd;
+        const uint8_t* _data;
+        size_t _size;
+        TrajectoryHeader _header;
+        std::vector<TrajectoryIndexEntry> _index;
+
+        // Last decoded frame
+        long _current;
+        std::vector<uint64_t> _ids;
+        std::vector<int64_t> _values[TRAJ_FIELD_COUNT];
+        std::vector<uint64_t> _nextIds;
+        std::vector<int64_t> _nextValues[TRAJ_FIELD_COUNT];
+};
+
+#endif
@@ -0,0 +1,136 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __TRAJECTORY_WRITER__
+#define __TRAJECTORY_WRITER__
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "ParticleSystem3D.hpp"
+#include "SpscQueue.hpp"
+#include "TrajectoryFormat.hpp"
+
+/**
+ * @brief What is recorded and how precisely
+*/
+struct TrajectoryOptions {
+    uint sampleEvery = 1;               // Record one step out of sampleEvery
+    std::vector<uint64_t> ids;          // Identifiers of the recorded particles (ascending), empty for all of them
+    bool velocities = false;            // Whether the velocities are recorded along with the positions and radiuses
+    double positionQuantum = 1.0 / 64;  // Quantization steps, in pixels and pixels per step
+    double radiusQuantum = 1.0 / 256;
+    double velocityQuantum = 1.0 / 1024;
+    uint keyframeInterval = 64;         // Number of frames in a chunk
+    uint queueCapacity = 4;             // Number of frames waiting to be written before new ones are dropped
+};
+
+/**
+ * @brief Particle state of one recorded step, as handed to the writer thread
+*/
+struct TrajectorySnapshot {
+    uint64_t step;
+    std::vector<uint64_t> ids;
+    std::vector<double> fields[TRAJ_FIELD_COUNT];
+};
+
+/**
+ * @brief Writes trajectory files (see TrajectoryFormat.hpp) from a thread of its own.
+ *        The simulation thread copies the sampled particles into a slot of a lock-free queue and goes on,
+ *        frames arriving while the queue is full are dropped rather than waiting for the disk.
+*/
+class TrajectoryWriter{
+    public:
+
+        /**
+         * @brief Constructor, nothing is written until open() is called
+        */
+        TrajectoryWriter();
+
+        /**
+         * @brief Destructor, closes the file
+        */
+        ~TrajectoryWriter();
+
+        /**
+         * @brief Create the file and start the writer thread
+         * @param path Path of the file to write
+         * @param options What is recorded and how precisely
+         * @return false if the file could not be created
+        */
+        bool open(const char* path, const TrajectoryOptions& options);
+
+        /**
+         * @brief Hand the state of a step to the writer thread, if the step is sampled. Never blocks
+         * @param particles The set of particles
+         * @param step Number of the simulation step
+         * @return false if the frame was dropped because the queue was full
+        */
+        template <typename T, typename TOffset>
+        bool record(const ParticleSystem3D<T, TOffset>& particles, uint64_t step);
+
+        /**
+         * @brief Write the frames still queued and the index, then close the file
+        */
+        void close();
+
+        /**
+         * @brief Whether a file is open
+        */
+        bool isOpen() const;
+
+        /**
+         * @brief Number of frames written so far
+        */
+        uint64_t framesWritten() const;
+
+        /**
+         * @brief Number of frames dropped because the queue was full
+        */
+        uint64_t framesDropped() const;
+
+        /**
+         * @brief Number of bytes written so far
+        */
+        uint64_t bytesWritten() const;
+
+    private:
+        /**
+         * @brief Loop of the writer thread: encode and write the queued frames until close() is called
+        */
+        void writerLoop();
+
+        /**
+         * @brief Encode a frame against the previous one and append it to the file
+         * @param snapshot The state to write
+        */
+        void writeFrame(const TrajectorySnapshot& snapshot);
+
+        TrajectoryOptions _options;
+        TrajectoryHeader _header;
+        FILE* _file;
+        std::thread _thread;
+        std::atomic<bool> _stop;
+
+        SpscQueue<TrajectorySnapshot>* _queue;
+
+        // Writer thread only
+        std::vector<TrajectoryIndexEntry> _index;
+        std::vector<uint64_t> _previousIds;
+        std::vector<int64_t> _previousValues[TRAJ_FIELD_COUNT];
+        std::vector<int64_t> _values[TRAJ_FIELD_COUNT];
+        std::vector<uint8_t> _payload;
+
+        std::atomic<uint64_t> _framesWritten;
+        std::atomic<uint64_t> _framesDropped;
+        std::atomic<uint64_t> _bytesWritten;
+};
+
+#endif
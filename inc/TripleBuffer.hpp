@@ -0,0 +1,93 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __TRIPLE_BUFFER__
+#define __TRIPLE_BUFFER__
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free triple buffer between one producer thread and one consumer thread, for states where only the latest
+ *        one matters. The producer fills its back buffer then publishes it, the consumer takes the latest published
+ *        buffer when it wants to. Neither side ever waits: the producer overwrites the buffers nobody took,
+ *        the consumer keeps its buffer until a newer one is published.
+ *        Each side owns its buffer between two calls, so the consumer may also modify the one it reads.
+ * @tparam T Type of the buffers
+*/
+template <typename T>
+class TripleBuffer{
+    public:
+
+        /**
+         * @brief Constructor
+        */
+        TripleBuffer();
+
+        /**
+         * @brief Producer side: buffer to fill
+        */
+        T& writeBuffer();
+
+        /**
+         * @brief Producer side: publish the buffer returned by writeBuffer(), the next call giving another one
+        */
+        void publish();
+
+        /**
+         * @brief Consumer side: take the latest published buffer, if one was published since the last call
+         * @return Whether readBuffer() changed
+        */
+        bool acquire();
+
+        /**
+         * @brief Consumer side: buffer taken by the last successful acquire()
+        */
+        T& readBuffer();
+
+    private:
+        static const uint8_t INDEX = 3;   // Bits of the index of a buffer
+        static const uint8_t FRESH = 4;   // Set when the middle buffer was published and not taken yet
+
+        T _buffers[3];
+        alignas(64) std::atomic<uint8_t> _middle;  // Buffer exchanged between the two sides, with the FRESH bit
+        alignas(64) uint8_t _back;                 // Buffer of the producer
+        alignas(64) uint8_t _front;                // Buffer of the consumer
+};
+
+template <typename T>
+TripleBuffer<T>::TripleBuffer()
+    : _buffers {}
+    , _middle {1}
+    , _back {0}
+    , _front {2}
+    {}
+
+template <typename T>
+T& TripleBuffer<T>::writeBuffer(){
+    return _buffers[_back];
+}
+
+template <typename T>
+void TripleBuffer<T>::publish(){
+    _back = _middle.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+}
+
+template <typename T>
+bool TripleBuffer<T>::acquire(){
+    if (!(_middle.load(std::memory_order_relaxed) & FRESH)){
+        return false;
+    }
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX;
+    return true;
+}
+
+template <typename T>
+T& TripleBuffer<T>::readBuffer(){
+    return _buffers[_front];
+}
+
+#endif
@@ -11,6 +11,10 @@ Created: 24/02/2024
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <Particle.hpp>
+#include <ParticleSystem3D.hpp>
+#include <FrameProfiler.hpp>
+#include <Rasterizer.hpp>
+#include <FrameExporter.hpp>
 
 class Window{
 
@@ -40,8 +44,10 @@ class Window{
          * @brief The class constructor
          * @param width Width of the window
          * @param height Height of the window
+         * @param headless Draw offscreen only, without initiating SDL: the particles are drawn by the software
+         *        rasterizer and only reach the exporter
         */
-        Window(uint width, uint height);
+        Window(uint width, uint height, bool headless = false);
 
         /**
          * @brief draw a circle on the window (This is an adaptation of the Midpoint circle algorithm)
@@ -52,17 +58,37 @@ class Window{
         void draw_circle(int x0, int y0, uint radius);
 
         /**
-         * @brief Draw a particle
+         * @brief Draw a particle, or add it to the density texture if it is smaller than a pixel
          * @param particle The particle to be drawn
         */
         void draw_particle(Particle particle);
 
         /**
-         * @brief Draw all the particles in the vector
+         * @brief Draw all the particles in the vector, the ones smaller than a pixel going to the density texture
+         *        drawn once at the end
          * @param particles A vector of particles
         */
         void draw_particles(std::vector<Particle>& particles);
 
+        /**
+         * @brief Draw all the particles of a 3D set, using an orthographic projection along the z axis.
+         *        Only the particles found by the octree under the window are drawn: they are first all moved to screen
+         *        coordinates, then their circles are drawn in one batch of points per shade. The ones smaller than a pixel
+         *        are added to a density texture drawn once at the end, brighter where more of them fall on the same pixel.
+         *        With software rendering, the visible particles are given to the rasterizer instead
+         * @param particles A 3D set of particles
+        */
+        template <typename T, typename TOffset>
+        void draw_particles(ParticleSystem3D<T, TOffset>& particles);
+
+        /**
+         * @brief Draw the duration of the phases of the last frames as stacked bars in the bottom left corner,
+         *        and show their averages in the title of the window
+         * @param profiler The profiler recording the frames
+         * @param physics Profiler of the physics thread, drawn to the right of the first one, ignored if null
+        */
+        void draw_profiler(const FrameProfiler& profiler, const FrameProfiler* physics = nullptr);
+
         /**
          * @brief Set the color used for the drawings
          * @param r Value for the red component
@@ -79,15 +105,108 @@ class Window{
         */
         void move_window(int x, int y);
 
+        /**
+         * @brief Multiply the zoom by a factor, the world point under (x, y) staying in place
+         * @param factor The factor applied to the zoom, above 1 to zoom in
+         * @param x The x coordinate of the fixed point, in window pixels
+         * @param y The y coordinate of the fixed point, in window pixels
+        */
+        void zoom_window(float factor, int x, int y);
+
+        /**
+         * @brief Choose how the particles are drawn: filled discs drawn by the software rasterizer and uploaded as one
+         *        texture per frame, or circles drawn by the SDL renderer
+         * @param enabled Whether the software rasterizer is used
+        */
+        void set_software_rendering(bool enabled);
+
+        /**
+         * @brief Whether the particles are drawn by the software rasterizer
+        */
+        bool is_software_rendering() const;
+
+        /**
+         * @brief Hand the frames drawn by the software rasterizer to an exporter, after drawing them on the window
+         * @param frame_exporter The exporter, none if null
+        */
+        void set_exporter(FrameExporter* frame_exporter);
+
 
 
     private:
+        /**
+         * @brief Append the points of a circle that fall inside the window (Midpoint circle algorithm)
+         * @param x0 the x coordinate of the center of the circle
+         * @param y0 the y coordinate of the center of the circle
+         * @param radius the radius of the circle (in pixels)
+         * @param points Receives the points
+        */
+        void circle_points(int x0, int y0, uint radius, std::vector<SDL_Point>& points) const;
+
+        /**
+         * @brief Draw the duration of the phases of the last frames of a profiler as stacked bars, starting from the bottom
+         * @param profiler The profiler recording the frames
+         * @param left The x coordinate of the first bar
+         * @param bar_width The width of a bar
+         * @param pixels_per_ms The height of one millisecond
+        */
+        void draw_profiler_bars(const FrameProfiler& profiler, uint left, uint bar_width, float pixels_per_ms);
+
+        /**
+         * @brief Whether a circle can be seen in the window
+         * @param x The x coordinate of the center of the circle, in window pixels
+         * @param y The y coordinate of the center of the circle, in window pixels
+         * @param radius The radius of the circle (in pixels)
+        */
+        bool is_visible(float x, float y, float radius) const;
+
+        /**
+         * @brief Add a particle smaller than a pixel to the density texture
+         * @param x The x coordinate of the particle, in window pixels
+         * @param y The y coordinate of the particle, in window pixels
+        */
+        void splat_point(float x, float y);
+
+        /**
+         * @brief Upload the rows of the density texture touched since the last call, draw them and clear them
+        */
+        void draw_density();
+
+        /**
+         * @brief Render the discs given to the software rasterizer, upload them and draw them over the whole window
+        */
+        void draw_software_frame();
+
+
         SDL_Window* window;
         SDL_Surface* w_surface;
         SDL_Renderer* gRenderer;
         uint w_width;
         uint w_height;
-        Vector<int> current_pos;  // Coordinates of the upper left corner, (0, 0) by default
+        Vector<float> current_pos;  // Position of the world origin in the window, (0, 0) by default
+        float zoom;                 // Window pixels per world unit, 1 by default
+
+        // Visible particles of a 3D set, moved to screen coordinates
+        std::vector<uint32_t> visible;
+        std::vector<float> screen_x;
+        std::vector<float> screen_y;
+        std::vector<float> screen_radius;
+        std::vector<uint8_t> screen_shade;
+        std::vector<SDL_Point> shade_points[16];  // Points of the circles of each shade, drawn in one call per shade
+        std::vector<SDL_Point> circle_buffer;     // Points of the circle drawn by draw_circle()
+
+        // Particles smaller than a pixel, accumulated during a frame
+        SDL_Texture* density_texture;
+        std::vector<uint16_t> density;         // Number of particles per pixel
+        std::vector<uint32_t> density_pixels;  // ARGB colors of the touched rows
+        int density_top;                       // Rows touched since the last draw, empty when top > bottom
+        int density_bottom;
+
+        // Software rendering, the only one without a renderer
+        bool software_rendering;
+        Rasterizer rasterizer;
+        SDL_Texture* frame_texture;
+        FrameExporter* exporter;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#ifndef __WORKER_POOL__
+#define __WORKER_POOL__
+
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "NumaTopology.hpp"
+
+/**
+ * @brief Threads kept alive between steps, each one owning the same part of every array it is given.
+ *        An array of n items is split in as many contiguous ranges as there are workers, worker w always getting the
+ *        w-th one. The workers are spread evenly over the NUMA nodes, the first ones on the first node, and each one can be
+ *        pinned to a CPU. An array whose pages are first written through the pool is then placed, page by page, on the
+ *        node of the worker that goes on reading it, and the loops run later through the pool read memory of their own node
+*/
+class WorkerPool{
+    public:
+
+        /**
+         * @brief Constructor, starts the workers
+         * @param nb_workers Number of workers, 0 for one per CPU the process may run on
+         * @param pin Whether each worker is bound to one CPU
+        */
+        WorkerPool(uint nb_workers = 0, bool pin = true);
+
+        /**
+         * @brief Destructor, stops the workers
+        */
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        /**
+         * @brief Call f(worker, begin, end) on the range of [0, n[ owned by each worker, in parallel, and wait for them.
+         *        Calls from several threads run one after the other
+         * @param n The number of items
+         * @param f The function called by each worker on its range, skipped for empty ranges
+        */
+        void forEachRange(size_t n, const std::function<void(uint, size_t, size_t)>& f);
+
+        /**
+         * @brief Call f(worker, begin, end) on ranges chosen by the caller, worker w getting [bounds[w], bounds[w + 1][,
+         *        in parallel, and wait for them
+         * @param bounds The size() + 1 bounds of the ranges, in increasing order
+         * @param f The function called by each worker on its range, skipped for empty ranges
+        */
+        void forEachPartition(const std::vector<size_t>& bounds, const std::function<void(uint, size_t, size_t)>& f);
+
+        /**
+         * @brief Write zeros over an array through the pool, so that each page is placed on the node of its owner.
+         *        Only the pages never written before move, the kernel placing a page on its first write
+         * @param data The array
+         * @param n The number of items
+        */
+        template <typename T>
+        void firstTouch(T* data, size_t n);
+
+        /**
+         * @brief First item of the range owned by a worker
+         * @param n The number of items
+         * @param worker The worker, size() for the end of the last range
+        */
+        size_t rangeBegin(size_t n, uint worker) const;
+
+        /**
+         * @brief Number of workers
+        */
+        uint size() const;
+
+        /**
+         * @brief CPU a worker is pinned to, -1 if it is not
+         * @param worker The worker
+        */
+        int cpu(uint worker) const;
+
+        /**
+         * @brief NUMA node of a worker
+         * @param worker The worker
+        */
+        int node(uint worker) const;
+
+        /**
+         * @brief Topology the workers were spread over
+        */
+        const NumaTopology& topology() const;
+
+        /**
+         * @brief Write the topology and where the workers run
+         * @param out The stream written to
+        */
+        void print(FILE* out) const;
+
+        static const size_t RANGE_ALIGN;  // The ranges start on multiples of this number of items, so that two workers
+                                          // rarely share a page
+
+    private:
+        /**
+         * @brief Loop of a worker: wait for a task, run it on its range, until the pool is destroyed
+         * @param worker Index of the worker
+        */
+        void workerLoop(uint worker);
+
+        NumaTopology _topology;
+        std::vector<std::thread> _threads;
+        std::vector<int> _cpus;   // CPU of each worker, -1 if not pinned
+        std::vector<int> _nodes;  // Node of each worker
+
+        std::mutex _callMutex;    // Held by the thread running forEachRange()
+        std::mutex _mutex;        // Protects the task and the counters below
+        std::condition_variable _taskReady;
+        std::condition_variable _taskDone;
+        const std::function<void(uint, size_t, size_t)>* _task;
+        size_t _taskSize;
+        const size_t* _taskBounds;  // Ranges of the current task, the owned ranges if null
+        uint64_t _generation;     // Number of tasks given so far
+        uint _pending;            // Workers still running the current task
+        bool _stop;
+};
+
+template <typename T>
+void WorkerPool::firstTouch(T* data, size_t n){
+    forEachRange(n, [data](uint, size_t begin, size_t end){
+        std::memset(static_cast<void*>(data + begin), 0, (end - begin) * sizeof(T));
+    });
+}
+
+#endif
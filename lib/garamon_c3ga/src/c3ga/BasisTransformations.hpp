@@ -9,7 +9,7 @@
 
 // \file BasisTransformations.hpp
 // \author V. Nozick, S. Breuils
-// \brief this files generates and load the elements of the transformation matrices into array of Eigen matrices 
+// \brief this files contains the elements of the transformation matrices as compile-time arrays 
 
 
 #ifndef C3GA_BASISTRANSFORMATIONS_HPP__
@@ -18,11 +18,7 @@
 
 
 #include <Eigen/Sparse>
-#include <vector>
 #include <array>
-#include <algorithm>
-#include <iterator>
-#include <sstream>
 
 
 /*!
@@ -30,188 +26,48 @@
  */
 namespace c3ga{
 
-	/// Decode the string encodedPerGradeMatrixComponents to a vector of T. This vector will contain the components of the transformation matrices
-	template<typename T>
-	const std::vector<T> decodeStringToVecOfT(std::string encodedPerGradeMatrixComponents) {
-	    std::vector<T> resultDecodedGrade;
-	    std::istringstream streamStringOverFloat(encodedPerGradeMatrixComponents);
-	    std::copy(std::istream_iterator<float>(streamStringOverFloat),
-		std::istream_iterator<float>(),
-		std::back_inserter(resultDecodedGrade));
-	    return resultDecodedGrade;
-	}
+	/// \brief one non-zero element of a per-grade transformation matrix
+	struct BasisTransformationEntry {
+		unsigned int row;   /*!< row of the element */
+		unsigned int col;   /*!< column of the element */
+		double value;       /*!< value of the element */
+	};
 
-	/// contains and load the components of the grade 0 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade0Matrix() {
-		const std::string grade0MatrixComponents = " 0 0 1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade0MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(1,1);
-		perGradeBasisTransformMatrix.reserve(1);
-		perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[0],(int)gradeVectorComponents[1]) = gradeVectorComponents[2];
-		return perGradeBasisTransformMatrix;
-	}
+	constexpr unsigned int maxBasisTransformationEntries = 16; /*!< maximum number of non-zero elements of a per-grade transformation matrix */
 
-	/// contains and load the components of the grade 1 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade1Matrix() {
-		const std::string grade1MatrixComponents = " 0 0 1.000000 4 0 -1.000000 0 1 1.000000 4 1 1.000000 2 2 1.000000 3 3 1.000000 1 4 1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade1MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(5,5);
-		perGradeBasisTransformMatrix.reserve(7);
-		for(unsigned int i=0;i<7;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
+	constexpr unsigned int basisTransformationSizes[6] = {1,5,10,10,5,1}; /*!< size of the (square) transformation matrix of each grade */
 
-	/// contains and load the components of the grade 2 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade2Matrix() {
-		const std::string grade2MatrixComponents = " 3 0 2.000000 1 1 1.000000 8 1 1.000000 2 2 1.000000 9 2 1.000000 0 3 1.000000 6 3 1.000000 1 4 1.000000 8 4 -1.000000 2 5 1.000000 9 5 -1.000000 0 6 1.000000 6 6 -1.000000 7 7 1.000000 4 8 -1.000000 5 9 -1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade2MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(10,10);
-		perGradeBasisTransformMatrix.reserve(16);
-		for(unsigned int i=0;i<16;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
+	constexpr unsigned int basisTransformationEntriesPerGrade[6] = {1,7,16,16,7,1}; /*!< number of non-zero elements of the transformation matrices (direct and inverse) of each grade */
 
-	/// contains and load the components of the grade 3 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade3Matrix() {
-		const std::string grade3MatrixComponents = " 4 0 -2.000000 5 1 -2.000000 2 2 -2.000000 3 3 1.000000 9 3 -1.000000 0 4 -1.000000 7 4 1.000000 1 5 -1.000000 8 5 1.000000 3 6 1.000000 9 6 1.000000 0 7 -1.000000 7 7 -1.000000 1 8 -1.000000 8 8 -1.000000 6 9 1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade3MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(10,10);
-		perGradeBasisTransformMatrix.reserve(16);
-		for(unsigned int i=0;i<16;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
+	constexpr BasisTransformationEntry transformationMatrices[6][maxBasisTransformationEntries] = {{{0,0,1.000000}}, {{0,0,1.000000},{4,0,-1.000000},{0,1,1.000000},{4,1,1.000000},{2,2,1.000000},{3,3,1.000000},{1,4,1.000000}}, {{3,0,2.000000},{1,1,1.000000},{8,1,1.000000},{2,2,1.000000},{9,2,1.000000},{0,3,1.000000},{6,3,1.000000},{1,4,1.000000},{8,4,-1.000000},{2,5,1.000000},{9,5,-1.000000},{0,6,1.000000},{6,6,-1.000000},{7,7,1.000000},{4,8,-1.000000},{5,9,-1.000000}}, {{4,0,-2.000000},{5,1,-2.000000},{2,2,-2.000000},{3,3,1.000000},{9,3,-1.000000},{0,4,-1.000000},{7,4,1.000000},{1,5,-1.000000},{8,5,1.000000},{3,6,1.000000},{9,6,1.000000},{0,7,-1.000000},{7,7,-1.000000},{1,8,-1.000000},{8,8,-1.000000},{6,9,1.000000}}, {{3,0,2.000000},{1,1,-2.000000},{2,2,-2.000000},{0,3,1.000000},{4,3,1.000000},{0,4,1.000000},{4,4,-1.000000}}, {{0,0,-2.000000}}}; /*!< non-zero elements of the transformation matrices, to transform a k-vector from the orhogonal basis to the original basis */
 
-	/// contains and load the components of the grade 4 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade4Matrix() {
-		const std::string grade4MatrixComponents = " 3 0 2.000000 1 1 -2.000000 2 2 -2.000000 0 3 1.000000 4 3 1.000000 0 4 1.000000 4 4 -1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade4MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(5,5);
-		perGradeBasisTransformMatrix.reserve(7);
-		for(unsigned int i=0;i<7;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
+	constexpr BasisTransformationEntry transformationMatricesInverse[6][maxBasisTransformationEntries] = {{{0,0,1.000000}}, {{0,0,0.500000},{1,0,0.500000},{4,1,1.000000},{2,2,1.000000},{3,3,1.000000},{0,4,-0.500000},{1,4,0.500000}}, {{3,0,0.500000},{6,0,0.500000},{1,1,0.500000},{4,1,0.500000},{2,2,0.500000},{5,2,0.500000},{0,3,0.500000},{8,4,-1.000000},{9,5,-1.000000},{3,6,0.500000},{6,6,-0.500000},{7,7,1.000000},{1,8,0.500000},{4,8,-0.500000},{2,9,0.500000},{5,9,-0.500000}}, {{4,0,-0.500000},{7,0,-0.500000},{5,1,-0.500000},{8,1,-0.500000},{2,2,-0.500000},{3,3,0.500000},{6,3,0.500000},{0,4,-0.500000},{1,5,-0.500000},{9,6,1.000000},{4,7,0.500000},{7,7,-0.500000},{5,8,0.500000},{8,8,-0.500000},{3,9,-0.500000},{6,9,0.500000}}, {{3,0,0.500000},{4,0,0.500000},{1,1,-0.500000},{2,2,-0.500000},{0,3,0.500000},{3,4,0.500000},{4,4,-0.500000}}, {{0,0,-0.500000}}}; /*!< non-zero elements of the transformation matrices, to transform a k-vector from the original basis to the orhogonal basis */
 
-	/// contains and load the components of the grade 5 direct transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade5Matrix() {
-		const std::string grade5MatrixComponents = " 0 0 -2.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade5MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(1,1);
-		perGradeBasisTransformMatrix.reserve(1);
-		perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[0],(int)gradeVectorComponents[1]) = gradeVectorComponents[2];
-		return perGradeBasisTransformMatrix;
-	}
-
-
-
-
-	/// contains and load the components of the grade 0 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade0InverseMatrix() {
-		const std::string grade0MatrixComponents = " 0 0 1.000000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade0MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(1,1);
-		perGradeBasisTransformMatrix.reserve(1);
-		perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[0],(int)gradeVectorComponents[1]) = gradeVectorComponents[2];
-		return perGradeBasisTransformMatrix;
-	}
 
-	/// contains and load the components of the grade 1 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade1InverseMatrix() {
-		const std::string grade1MatrixComponents = " 0 0 0.500000 1 0 0.500000 4 1 1.000000 2 2 1.000000 3 3 1.000000 0 4 -0.500000 1 4 0.500000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade1MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(5,5);
-		perGradeBasisTransformMatrix.reserve(7);
-		for(unsigned int i=0;i<7;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
-
-	/// contains and load the components of the grade 2 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade2InverseMatrix() {
-		const std::string grade2MatrixComponents = " 3 0 0.500000 6 0 0.500000 1 1 0.500000 4 1 0.500000 2 2 0.500000 5 2 0.500000 0 3 0.500000 8 4 -1.000000 9 5 -1.000000 3 6 0.500000 6 6 -0.500000 7 7 1.000000 1 8 0.500000 4 8 -0.500000 2 9 0.500000 5 9 -0.500000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade2MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(10,10);
-		perGradeBasisTransformMatrix.reserve(16);
-		for(unsigned int i=0;i<16;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
-
-	/// contains and load the components of the grade 3 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade3InverseMatrix() {
-		const std::string grade3MatrixComponents = " 4 0 -0.500000 7 0 -0.500000 5 1 -0.500000 8 1 -0.500000 2 2 -0.500000 3 3 0.500000 6 3 0.500000 0 4 -0.500000 1 5 -0.500000 9 6 1.000000 4 7 0.500000 7 7 -0.500000 5 8 0.500000 8 8 -0.500000 3 9 -0.500000 6 9 0.500000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade3MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(10,10);
-		perGradeBasisTransformMatrix.reserve(16);
-		for(unsigned int i=0;i<16;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
-
-	/// contains and load the components of the grade 4 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade4InverseMatrix() {
-		const std::string grade4MatrixComponents = " 3 0 0.500000 4 0 0.500000 1 1 -0.500000 2 2 -0.500000 0 3 0.500000 3 4 0.500000 4 4 -0.500000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade4MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(5,5);
-		perGradeBasisTransformMatrix.reserve(7);
-		for(unsigned int i=0;i<7;++i)
-			perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[3*i],(int)gradeVectorComponents[(3*i)+1]) = gradeVectorComponents[(3*i)+2];
-		return perGradeBasisTransformMatrix;
-	}
-
-	/// contains and load the components of the grade 5 inverse transformation matrix 
- 	template<typename T>
-	Eigen::SparseMatrix<T, Eigen::ColMajor>  loadgrade5InverseMatrix() {
-		const std::string grade5MatrixComponents = " 0 0 -0.500000 ";
-		std::vector<T> gradeVectorComponents = decodeStringToVecOfT<T>(grade5MatrixComponents);
-		Eigen::SparseMatrix<T, Eigen::ColMajor> perGradeBasisTransformMatrix		 = Eigen::SparseMatrix<T, Eigen::ColMajor>(1,1);
-		perGradeBasisTransformMatrix.reserve(1);
-		perGradeBasisTransformMatrix.insert((int)gradeVectorComponents[0],(int)gradeVectorComponents[1]) = gradeVectorComponents[2];
-		return perGradeBasisTransformMatrix;
+	/// \brief build the Eigen sparse matrices from the non-zero elements of the transformation matrices of all grades
+	template<typename T>
+	const std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> loadMatricesFromEntries(const BasisTransformationEntry (&matrix)[6][maxBasisTransformationEntries]) {
+		std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> sparseMatrices;
+		for(unsigned int grade=0;grade<6;++grade){
+			sparseMatrices[grade] = Eigen::SparseMatrix<T, Eigen::ColMajor>(basisTransformationSizes[grade],basisTransformationSizes[grade]);
+			sparseMatrices[grade].reserve(basisTransformationEntriesPerGrade[grade]);
+			for(unsigned int i=0;i<basisTransformationEntriesPerGrade[grade];++i)
+				sparseMatrices[grade].insert(matrix[grade][i].row, matrix[grade][i].col) = T(matrix[grade][i].value);
+		}
+		return sparseMatrices;
 	}
 
-
-
-
 	/// initialize all the direct transformation matrices using array of eigen sparse matrices
 	template<typename T>
 	const std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> loadMatrices() {
-		std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6>  transformationMatrices;
-		transformationMatrices[0] = loadgrade0Matrix<T>();
-		transformationMatrices[1] = loadgrade1Matrix<T>();
-		transformationMatrices[2] = loadgrade2Matrix<T>();
-		transformationMatrices[3] = loadgrade3Matrix<T>();
-		transformationMatrices[4] = loadgrade4Matrix<T>();
-		transformationMatrices[5] = loadgrade5Matrix<T>();
-		return transformationMatrices;
+		return loadMatricesFromEntries<T>(transformationMatrices);
 	}
 
 
 	/// initialize all the inverse transformation matrices using array of eigen sparse matrices
 	template<typename T>
 	const std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> loadMatricesInverse() {
-		std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6>  transformationMatrices;
-		transformationMatrices[0] = loadgrade0InverseMatrix<T>();
-		transformationMatrices[1] = loadgrade1InverseMatrix<T>();
-		transformationMatrices[2] = loadgrade2InverseMatrix<T>();
-		transformationMatrices[3] = loadgrade3InverseMatrix<T>();
-		transformationMatrices[4] = loadgrade4InverseMatrix<T>();
-		transformationMatrices[5] = loadgrade5InverseMatrix<T>();
-		return transformationMatrices;
+		return loadMatricesFromEntries<T>(transformationMatricesInverse);
 	}
 
 
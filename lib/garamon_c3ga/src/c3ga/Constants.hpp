@@ -40,9 +40,6 @@
 
 
 #include <array>
-#include <vector>
-#include <utility>
-#include <string>
 #include <Eigen/Sparse>
 
 #include "c3ga/Utility.hpp"
@@ -65,20 +62,18 @@ namespace c3ga{
 
     constexpr unsigned int xorIndexToHomogeneousIndex[] = {0,0,1,0,2,1,4,0,3,2,5,1,7,3,6,0,4,3,6,2,8,4,7,1,9,5,8,2,9,3,4,0}; /*!< given a Xor index in a multivector, this array indicates the corresponding index in the whole homogeneous vector*/
 
-    const std::array<std::vector<unsigned int>, 6> dualPermutations = {{ { 0}, {{ 0,3,2,1,4}}, {{ 3,1,0,6,5,4,9,2,8,7}}, {{ 2,1,7,0,5,4,3,9,8,6}}, {{ 0,3,2,1,4}}, {0} }}; /*!< array referring to some permutations required to compute the dual. */
+    constexpr unsigned int dualPermutations[6][10] = { { 0}, { 0,3,2,1,4}, { 3,1,0,6,5,4,9,2,8,7}, { 2,1,7,0,5,4,3,9,8,6}, { 0,3,2,1,4}, {0} }; /*!< array referring to some permutations required to compute the dual. */
 
-    const std::array<Eigen::Matrix<double, Eigen::Dynamic,1>, 6> dualCoefficients = loadFastDualArray<double>(); /*!< array containing some basis change coefficients required to compute the dual */
-    
     template<typename T>
-    std::array<T, 32> recursiveDualCoefficients = {{ 1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000}}; /*!< array containing the coefficients needed to compute the recursive product like (primal^dual) */
+    constexpr std::array<T, 32> recursiveDualCoefficients = {{ 1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000,1.000000,-1.000000,-1.000000,-1.000000,-1.000000,1.000000,1.000000,1.000000,1.000000}}; /*!< array containing the coefficients needed to compute the recursive product like (primal^dual) */
 
     constexpr double pseudoScalarInverse = -1.000000; /*!< compute the inverse of the pseudo scalar */
 
-    const int signReversePerGrade[6] = {1,1,-1,-1,1,1}; /*!< array of signs to avoid the computation of (-1)^k*(k-1)/2 during the reverse operation */
+    constexpr int signReversePerGrade[6] = {1,1,-1,-1,1,1}; /*!< array of signs to avoid the computation of (-1)^k*(k-1)/2 during the reverse operation */
 
-    const std::vector<std::string> basisVectors = {"0", "1", "2", "3", "i"}; /*!< name of the basis vectors (of grade 1) */
+    constexpr const char* basisVectors[5] = {"0", "1", "2", "3", "i"}; /*!< name of the basis vectors (of grade 1) */
 
-    const std::string metric =
+    constexpr const char* metric =
 "\
 	e0	e1	e2	e3	ei	\n\
 e0	0	0	0	0	-1	\n\
@@ -127,13 +122,7 @@ ei	-1	0	0	0	0	\n\
     /*!< defines the constants for the cga */
 
     template<typename T>
-    const std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> transformationMatrices = loadMatrices<T>(); /*!< set transformation matrices to transform a k-vector from the orhogonal basis to the original basis */
-    template<typename T>
-    const std::array<Eigen::SparseMatrix<T, Eigen::ColMajor>,6> transformationMatricesInverse = loadMatricesInverse<T>(); /*!< set transformation matrices to transform a k-vector from the original basis to the orhogonal basis */
-
-
-    template<typename T>
-    Eigen::Matrix<T, Eigen::Dynamic, 1> diagonalMetric = []()->Eigen::Matrix<T,Eigen::Dynamic,Eigen::Dynamic>{Eigen::Matrix<T, Eigen::Dynamic, 1> tmp(5);tmp<<2.000000,-2.000000,1.000000,1.000000,1.000000; return tmp;}();   /*!< defines the diagonal metric (stored as a vector) */
+    constexpr T diagonalMetric[5] = {2.000000,-2.000000,1.000000,1.000000,1.000000};   /*!< defines the diagonal metric (stored as a vector) */
 
 
 }  // namespace
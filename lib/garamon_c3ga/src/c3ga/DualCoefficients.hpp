@@ -8,7 +8,7 @@
 // A a copy of the MIT License is given along with this program
 
 // \file DualCoefficients.hpp
-// \brief this files generates and load the elements of the fast dual into array of Eigen matrices 
+// \brief this files contains the coefficients of the fast dual as a compile-time array 
 // \author V. Nozick, S. Breuils
 
 #ifndef C3GA_DUALCOEFFICIENTS_HPP__
@@ -16,12 +16,8 @@
 #pragma once
 
 
-#include <Eigen/Sparse>
-#include <vector>
+#include <Eigen/Core>
 #include <array>
-#include <algorithm>
-#include <iterator>
-#include <sstream>
 
 
 /*!
@@ -29,47 +25,18 @@
  */
 namespace c3ga{
 
-	/// Decode the string encodedPerGradeMatrixComponents to a vector of T. This vector will contain the coefficients used to compute the dual
-	template<typename T>
-	const std::vector<T> decodeStringOfDualCoefToVecOfT(std::string encodedPerGradeMatrixComponents) {
-	    std::vector<T> resultDecodedGrade;
-	    std::istringstream streamStringOverFloat(encodedPerGradeMatrixComponents);
-	    std::copy(std::istream_iterator<float>(streamStringOverFloat),
-		std::istream_iterator<float>(),
-		std::back_inserter(resultDecodedGrade));
-	    return resultDecodedGrade;
-	}
+	constexpr double dualCoefficients[32] = {1.000000,-1.000000,-1.000000,1.000000,-1.000000,-1.000000,-1.000000,1.000000,-1.000000,-1.000000,1.000000,-1.000000,-1.000000,-1.000000,1.000000,-1.000000,1.000000,-1.000000,1.000000,1.000000,1.000000,-1.000000,1.000000,1.000000,-1.000000,1.000000,1.000000,1.000000,-1.000000,1.000000,1.000000,-1.000000}; /*!< coefficients required to compute the dual, stored as a whole multivector: the coefficients of grade k start at perGradeStartingIndex[k] */
 
 
 	/// load the coefficients of the dual into array of Eigen matrices 
 	template<typename T>
 	const std::array<Eigen::Matrix<T, Eigen::Dynamic,1>,6> loadFastDualArray() {
+		constexpr unsigned int gradeStartingIndex[7] = {0,1,6,16,26,31,32};
 		std::array<Eigen::Matrix<T, Eigen::Dynamic,1>,6> dualArrayCoefficients;
-		std::string stringDualCoefficients="1.000000 -1.000000 -1.000000 1.000000 -1.000000 -1.000000 -1.000000 1.000000 -1.000000 -1.000000 1.000000 -1.000000 -1.000000 -1.000000 1.000000 -1.000000 1.000000 -1.000000 1.000000 1.000000 1.000000 -1.000000 1.000000 1.000000 -1.000000 1.000000 1.000000 1.000000 -1.000000 1.000000 1.000000 -1.000000 ";
-		const std::vector<T> vectorDualComponents = decodeStringOfDualCoefToVecOfT<T>(stringDualCoefficients);
-		dualArrayCoefficients[0]= Eigen::Matrix<T, Eigen::Dynamic,1>(1);
-		for(unsigned int i=0;i<1;++i){
-			dualArrayCoefficients[0].coeffRef(i-0) = (T)vectorDualComponents[i]; 
-		}
-		dualArrayCoefficients[1]= Eigen::Matrix<T, Eigen::Dynamic,1>(5);
-		for(unsigned int i=1;i<6;++i){
-			dualArrayCoefficients[1].coeffRef(i-1) = (T)vectorDualComponents[i]; 
-		}
-		dualArrayCoefficients[2]= Eigen::Matrix<T, Eigen::Dynamic,1>(10);
-		for(unsigned int i=6;i<16;++i){
-			dualArrayCoefficients[2].coeffRef(i-6) = (T)vectorDualComponents[i]; 
-		}
-		dualArrayCoefficients[3]= Eigen::Matrix<T, Eigen::Dynamic,1>(10);
-		for(unsigned int i=16;i<26;++i){
-			dualArrayCoefficients[3].coeffRef(i-16) = (T)vectorDualComponents[i]; 
-		}
-		dualArrayCoefficients[4]= Eigen::Matrix<T, Eigen::Dynamic,1>(5);
-		for(unsigned int i=26;i<31;++i){
-			dualArrayCoefficients[4].coeffRef(i-26) = (T)vectorDualComponents[i]; 
-		}
-		dualArrayCoefficients[5]= Eigen::Matrix<T, Eigen::Dynamic,1>(1);
-		for(unsigned int i=31;i<32;++i){
-			dualArrayCoefficients[5].coeffRef(0) = (T)vectorDualComponents[i]; 
+		for(unsigned int grade=0;grade<6;++grade){
+			dualArrayCoefficients[grade] = Eigen::Matrix<T, Eigen::Dynamic,1>(gradeStartingIndex[grade+1]-gradeStartingIndex[grade]);
+			for(unsigned int i=gradeStartingIndex[grade];i<gradeStartingIndex[grade+1];++i)
+				dualArrayCoefficients[grade].coeffRef(i-gradeStartingIndex[grade]) = (T)dualCoefficients[i];
 		}
 		return dualArrayCoefficients;
 	}
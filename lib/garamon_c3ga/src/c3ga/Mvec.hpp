@@ -20,6 +20,8 @@
 // External Includes
 #include <Eigen/Core>
 #include <list>
+#include <vector>
+#include <string>
 #include <iostream>
 #include <cmath>
 #include <limits>
@@ -1400,7 +1402,8 @@ namespace c3ga{
                 kvec.vec.coeffRef(dualPermutations[itMv->grade][i]) = itMv->vec.coeff(i);
 
             // the inner product may involve some constant multiplucation for the dual elements
-            kvec.vec = kvec.vec.cwiseProduct(dualCoefficients[itMv->grade].template cast<T>());
+            for(unsigned int i=0;i<binomialArray[itMv->grade];++i)
+                kvec.vec.coeffRef(i) *= T(dualCoefficients[perGradeStartingIndex[itMv->grade] + i]);
 
             // add the k-vector to the resulting multivector
             mvResult.mvData.push_back(kvec);
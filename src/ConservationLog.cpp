@@ -0,0 +1,119 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <ConservationLog.hpp>
+#include <cmath>
+#include <algorithm>
+
+/**
+ * @brief Relative difference between two vectors, |a - b| / |b|
+ * @param a The vector compared
+ * @param b The reference vector
+*/
+static double relativeDifference(const double a[3], const double b[3]){
+    double diff = std::sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+    double norm = std::sqrt(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+    return norm > 0 ? diff / norm : diff;
+}
+
+/**
+ * @brief Constructor, nothing is written until open() is called
+*/
+ConservationLog::ConservationLog()
+    : _file {NULL}
+    , _samples {0}
+    , _first {}
+    , _maxEnergyDrift {0}
+    , _maxAngularMomentumDrift {0}
+    {}
+
+/**
+ * @brief Destructor, closes the file
+*/
+ConservationLog::~ConservationLog(){
+    close();
+}
+
+/**
+ * @brief Create the file and write the header of the columns
+ * @param path Path of the file
+ * @return false if the file cannot be created
+*/
+bool ConservationLog::open(const char* path){
+    close();
+    _file = fopen(path, "w");
+    if (_file == NULL){
+        fprintf(stderr, "Could not create the diagnostics file %s\n", path);
+        return false;
+    }
+    fprintf(_file, "step,particles,kinetic,potential,total,energy_drift,px,py,pz,lx,ly,lz,angular_momentum_drift\n");
+    _samples = 0;
+    _maxEnergyDrift = 0;
+    _maxAngularMomentumDrift = 0;
+    return true;
+}
+
+/**
+ * @brief Append a sample, the first one being the reference of the drifts
+ * @param sample The sample
+*/
+void ConservationLog::record(const ConservationSample& sample){
+    if (_samples == 0){
+        _first = sample;
+    }
+    _samples++;
+
+    double energy = sample.kinetic + sample.potential;
+    double first_energy = _first.kinetic + _first.potential;
+    double energy_drift = first_energy != 0 ? std::abs((energy - first_energy) / first_energy) : std::abs(energy);
+    double angular_drift = relativeDifference(sample.angularMomentum, _first.angularMomentum);
+    _maxEnergyDrift = std::max(_maxEnergyDrift, energy_drift);
+    _maxAngularMomentumDrift = std::max(_maxAngularMomentumDrift, angular_drift);
+
+    if (_file != NULL){
+        fprintf(_file, "%llu,%zu,%.10g,%.10g,%.10g,%.4e,%.10g,%.10g,%.10g,%.10g,%.10g,%.10g,%.4e\n",
+                (unsigned long long) sample.step, sample.nbParticles, sample.kinetic, sample.potential, energy, energy_drift,
+                sample.momentum[0], sample.momentum[1], sample.momentum[2],
+                sample.angularMomentum[0], sample.angularMomentum[1], sample.angularMomentum[2], angular_drift);
+    }
+}
+
+/**
+ * @brief Flush and close the file
+*/
+void ConservationLog::close(){
+    if (_file != NULL){
+        fclose(_file);
+        _file = NULL;
+    }
+}
+
+/**
+ * @brief Whether a file is open
+*/
+bool ConservationLog::isOpen() const{
+    return _file != NULL;
+}
+
+/**
+ * @brief Number of samples recorded
+*/
+size_t ConservationLog::sampleCount() const{
+    return _samples;
+}
+
+/**
+ * @brief Largest |E - E0| / |E0| over the samples, E being the total energy
+*/
+double ConservationLog::maxEnergyDrift() const{
+    return _maxEnergyDrift;
+}
+
+/**
+ * @brief Largest |L - L0| / |L0| over the samples, L being the angular momentum
+*/
+double ConservationLog::maxAngularMomentumDrift() const{
+    return _maxAngularMomentumDrift;
+}
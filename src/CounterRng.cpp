@@ -0,0 +1,62 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <CounterRng.hpp>
+
+/**
+ * @brief SplitMix64 finalizer, a bijection of the 64 bits integers with a good avalanche
+ * @param z The value to mix
+*/
+static inline uint64_t mix64(uint64_t z){
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static const uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;  // SplitMix64 increment
+
+/**
+ * @brief Constructor
+ * @param seed Seed of the run
+ * @param stream Number of the stream, typically the index of the particle being generated
+*/
+CounterRng::CounterRng(uint64_t seed, uint64_t stream)
+    : _key {mix64(seed + GOLDEN_GAMMA) ^ mix64((stream + 1) * GOLDEN_GAMMA)}
+    , _counter {0}
+    {}
+
+/**
+ * @brief Next 64 bits integer of the stream
+*/
+uint64_t CounterRng::nextUInt(){
+    _counter++;
+    return mix64(_key + _counter * GOLDEN_GAMMA);
+}
+
+/**
+ * @brief Next integer of the stream in [0, bound[
+ * @param bound The excluded upper bound, must not be 0
+*/
+uint64_t CounterRng::nextUInt(uint64_t bound){
+    // Multiply-shift reduction, unbiased enough for the bounds used here (< 2^32)
+    return (uint64_t) (((unsigned __int128) nextUInt() * bound) >> 64);
+}
+
+/**
+ * @brief Next real of the stream in [0, 1[
+*/
+double CounterRng::nextDouble(){
+    // 53 random bits in the mantissa
+    return (nextUInt() >> 11) * 0x1.0p-53;
+}
+
+/**
+ * @brief Next real of the stream in [min, max[
+ * @param min The included lower bound
+ * @param max The excluded upper bound
+*/
+double CounterRng::uniform(double min, double max){
+    return min + (max - min) * nextDouble();
+}
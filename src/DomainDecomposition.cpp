@@ -0,0 +1,628 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <DomainDecomposition.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+template <typename T, typename TOffset>
+const uint DomainDecomposition<T, TOffset>::MAX_DOMAINS = 64;
+
+/**
+ * @brief Read exactly size bytes from a socket
+ * @return false if the other end was closed
+*/
+static bool readAll(int socket, void* data, size_t size){
+    char* bytes = static_cast<char*>(data);
+    while (size > 0){
+        ssize_t got = recv(socket, bytes, size, 0);
+        if (got <= 0){
+            return false;
+        }
+        bytes += got;
+        size -= got;
+    }
+    return true;
+}
+
+/**
+ * @brief Write exactly size bytes to a socket
+ * @return false if the other end was closed
+*/
+static bool writeAll(int socket, const void* data, size_t size){
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0){
+        ssize_t sent = send(socket, bytes, size, MSG_NOSIGNAL);
+        if (sent <= 0){
+            return false;
+        }
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Close every descriptor of the process but one, so that a worker does not hold the pipes and files
+ *        of the coordinator open
+ * @param keep The descriptor kept
+*/
+static void closeDescriptors(int keep){
+    DIR* directory = opendir("/proc/self/fd");
+    if (directory == nullptr){
+        long limit = sysconf(_SC_OPEN_MAX);
+        for (int fd = 0; fd < (limit > 0 ? limit : 1024); fd++){
+            if (fd != keep){
+                close(fd);
+            }
+        }
+        return;
+    }
+    std::vector<int> descriptors;
+    while (struct dirent* entry = readdir(directory)){
+        if (entry->d_name[0] != '.'){
+            int fd = std::atoi(entry->d_name);
+            if (fd != keep && fd != dirfd(directory)){
+                descriptors.push_back(fd);
+            }
+        }
+    }
+    closedir(directory);
+    for (int fd : descriptors){
+        close(fd);
+    }
+}
+
+/**
+ * @brief Constructor, no worker runs until start() is called
+*/
+template <typename T, typename TOffset>
+DomainDecomposition<T, TOffset>::DomainDecomposition()
+    : _nbDomains {0}
+    , _capacity {0}
+    , _shared {nullptr}
+    , _sharedBytes {0}
+    , _pool {nullptr}
+    , _steps {0}
+    , _lastImbalance {1}
+    , _imbalanceSum {0}
+    , _importedSum {0}
+    {}
+
+/**
+ * @brief Destructor, stops the workers
+*/
+template <typename T, typename TOffset>
+DomainDecomposition<T, TOffset>::~DomainDecomposition(){
+    stop();
+}
+
+/**
+ * @brief Map the shared memory and fork the workers
+ * @param nb_domains Number of domains, one worker process each
+ * @param capacity Largest number of particles
+ * @return false if the workers could not be started
+*/
+template <typename T, typename TOffset>
+bool DomainDecomposition<T, TOffset>::start(uint nb_domains, size_t capacity){
+    stop();
+    _nbDomains = std::min(std::max(1u, nb_domains), MAX_DOMAINS);
+    _capacity = std::max<size_t>(1, capacity);
+    size_t domains = _nbDomains;
+
+    // Each domain sends every other one at most one body per particle, a cell standing for several of them
+    size_t offsets[15];
+    size_t sizes[15] = {sizeof(Header), 3 * domains * sizeof(double), 3 * domains * sizeof(double), (domains + 1) * sizeof(uint64_t),
+                        domains * domains * sizeof(uint64_t), domains * domains * sizeof(uint64_t),
+                        _capacity * sizeof(T), _capacity * sizeof(T), _capacity * sizeof(T), _capacity * sizeof(TOffset),
+                        _capacity * sizeof(TOffset), _capacity * sizeof(TOffset), _capacity * sizeof(TOffset), _capacity * sizeof(TOffset),
+                        _capacity * sizeof(uint32_t)};
+    _sharedBytes = 0;
+    for (int k = 0; k < 15; k++){
+        offsets[k] = _sharedBytes;
+        _sharedBytes += (sizes[k] + 63) / 64 * 64;
+    }
+    size_t bodies_offset = _sharedBytes;
+    _sharedBytes += (domains - 1) * _capacity * sizeof(Body);
+
+    // Only the pages written are allocated, the room for the bodies is mostly never used
+    _shared = mmap(nullptr, _sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (_shared == MAP_FAILED){
+        _shared = nullptr;
+        fprintf(stderr, "Could not map %zu bytes shared with the domain workers\n", _sharedBytes);
+        return false;
+    }
+    char* base = static_cast<char*>(_shared);
+    _header = reinterpret_cast<Header*>(base + offsets[0]);
+    _lo = reinterpret_cast<double*>(base + offsets[1]);
+    _hi = reinterpret_cast<double*>(base + offsets[2]);
+    _domainStart = reinterpret_cast<uint64_t*>(base + offsets[3]);
+    _exportStart = reinterpret_cast<uint64_t*>(base + offsets[4]);
+    _exportCount = reinterpret_cast<uint64_t*>(base + offsets[5]);
+    _x = reinterpret_cast<T*>(base + offsets[6]);
+    _y = reinterpret_cast<T*>(base + offsets[7]);
+    _z = reinterpret_cast<T*>(base + offsets[8]);
+    _mass = reinterpret_cast<TOffset*>(base + offsets[9]);
+    _ax = reinterpret_cast<TOffset*>(base + offsets[10]);
+    _ay = reinterpret_cast<TOffset*>(base + offsets[11]);
+    _az = reinterpret_cast<TOffset*>(base + offsets[12]);
+    _phi = reinterpret_cast<TOffset*>(base + offsets[13]);
+    _order = reinterpret_cast<uint32_t*>(base + offsets[14]);
+    _bodies = reinterpret_cast<Body*>(base + bodies_offset);
+
+    // All the sockets exist before the first fork, each worker keeping only its own end
+    std::vector<int> worker_ends;
+    for (uint d = 0; d < _nbDomains; d++){
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0){
+            fprintf(stderr, "Could not create the socket of domain %u\n", d);
+            for (int end : worker_ends){
+                close(end);
+            }
+            stop();
+            return false;
+        }
+        _sockets.push_back(pair[0]);
+        worker_ends.push_back(pair[1]);
+    }
+
+    for (uint d = 0; d < _nbDomains; d++){
+        pid_t pid = fork();
+        if (pid == 0){
+            closeDescriptors(worker_ends[d]);
+            workerMain(d, worker_ends[d]);
+        }
+        close(worker_ends[d]);
+        if (pid < 0){
+            fprintf(stderr, "Could not start the worker of domain %u\n", d);
+            for (uint other = d + 1; other < _nbDomains; other++){
+                close(worker_ends[other]);
+            }
+            stop();
+            return false;
+        }
+        _workers.push_back(pid);
+    }
+
+    _cost.assign(_nbDomains, 0);
+    _costPerParticle.assign(_nbDomains, 1);
+    _splits.assign(2 * _nbDomains, Split {0, 0});
+    _steps = 0;
+    _lastImbalance = 1;
+    _imbalanceSum = 0;
+    _importedSum = 0;
+    return true;
+}
+
+/**
+ * @brief Stop the workers and unmap the shared memory
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::stop(){
+    uint32_t command = COMMAND_STOP;
+    for (int socket : _sockets){
+        writeAll(socket, &command, sizeof(command));
+        close(socket);
+    }
+    for (pid_t worker : _workers){
+        waitpid(worker, NULL, 0);
+    }
+    _sockets.clear();
+    _workers.clear();
+
+    if (_shared != nullptr){
+        munmap(_shared, _sharedBytes);
+        _shared = nullptr;
+    }
+}
+
+/**
+ * @brief Whether the workers are running
+*/
+template <typename T, typename TOffset>
+bool DomainDecomposition<T, TOffset>::isRunning() const{
+    return !_workers.empty();
+}
+
+/**
+ * @brief Prepare the arrays of the workers and cut the domains on a pool of threads
+ * @param pool The threads, the calling thread doing everything if null. It must outlive the decomposition
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::setWorkerPool(WorkerPool* pool){
+    _pool = pool;
+}
+
+/**
+ * @brief Compute the gravitational acceleration of every particle on the workers
+ * @param G The gravitational constant
+ * @param softening Shape of the force at short distance
+ * @param x Array of x coordinates
+ * @param y Array of y coordinates
+ * @param z Array of z coordinates
+ * @param mass Array of masses
+ * @param n The number of particles
+ * @param ax Array receiving the x component of the accelerations
+ * @param ay Array receiving the y component of the accelerations
+ * @param az Array receiving the z component of the accelerations
+ * @param phi Array receiving the gravitational potentials, ignored if null
+ * @return false if nothing was computed: more particles than the capacity, or a worker stopped answering,
+ *         in which case the workers are stopped
+*/
+template <typename T, typename TOffset>
+bool DomainDecomposition<T, TOffset>::computeAccelerations(double G, const Softening<TOffset>& softening, const T* x, const T* y, const T* z,
+                                                           const TOffset* mass, size_t n, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi){
+    if (!isRunning() || n > _capacity){
+        return false;
+    }
+
+    _header->n = n;
+    _header->potential = phi != nullptr;
+    _header->kernel = softening.kernel();
+    _header->softening = softening.length();
+    _header->G = G;
+
+    // Each particle weighs the time per particle of the domain it falls in, on the last bisection
+    _weights.resize(n);
+    auto prepare = [&](size_t begin, size_t end){
+        std::copy(x + begin, x + end, _x + begin);
+        std::copy(y + begin, y + end, _y + begin);
+        std::copy(z + begin, z + end, _z + begin);
+        std::copy(mass + begin, mass + end, _mass + begin);
+        for (size_t i = begin; i < end; i++){
+            double position[3] = {(double) x[i], (double) y[i], (double) z[i]};
+            _weights[i] = _steps == 0 ? 1 : _costPerParticle[locate(position)];
+            _order[i] = i;
+        }
+    };
+    if (_pool != nullptr){
+        _pool->forEachRange(n, [&](uint, size_t begin, size_t end){
+            prepare(begin, end);
+        });
+    }
+    else {
+        prepare(0, n);
+    }
+    bisect(0, n, 0, _nbDomains, 0);
+    _domainStart[_nbDomains] = n;
+
+    std::fill(_cost.begin(), _cost.end(), 0);
+    if (!broadcast(COMMAND_EXPORT) || !broadcast(COMMAND_COMPUTE)){
+        fprintf(stderr, "A domain worker stopped, the gravity goes back to this process\n");
+        stop();
+        return false;
+    }
+
+    std::copy(_ax, _ax + n, ax);
+    std::copy(_ay, _ay + n, ay);
+    std::copy(_az, _az + n, az);
+    if (phi != nullptr){
+        std::copy(_phi, _phi + n, phi);
+    }
+
+    // Cost model of the next bisection
+    double total = 0;
+    double slowest = 0;
+    for (uint d = 0; d < _nbDomains; d++){
+        total += _cost[d];
+        slowest = std::max(slowest, _cost[d]);
+    }
+    double average = total / _nbDomains;
+    for (uint d = 0; d < _nbDomains; d++){
+        size_t count = _domainStart[d + 1] - _domainStart[d];
+        _costPerParticle[d] = count > 0 ? std::max(_cost[d], 1e-9) / count : (n > 0 ? total / n : 1);
+    }
+    _lastImbalance = average > 0 ? slowest / average : 1;
+    _imbalanceSum += _lastImbalance;
+    for (size_t k = 0; k < (size_t) _nbDomains * _nbDomains; k++){
+        _importedSum += (double) _exportCount[k] / _nbDomains;
+    }
+    _steps++;
+    return true;
+}
+
+/**
+ * @brief Number of domains
+*/
+template <typename T, typename TOffset>
+uint DomainDecomposition<T, TOffset>::domainCount() const{
+    return _nbDomains;
+}
+
+/**
+ * @brief Number of steps computed by the workers
+*/
+template <typename T, typename TOffset>
+uint64_t DomainDecomposition<T, TOffset>::stepCount() const{
+    return _steps;
+}
+
+/**
+ * @brief Time of the slowest domain over the average time of a domain, for the last step
+*/
+template <typename T, typename TOffset>
+double DomainDecomposition<T, TOffset>::lastImbalance() const{
+    return _lastImbalance;
+}
+
+/**
+ * @brief Time of the slowest domain over the average time of a domain, averaged over the steps
+*/
+template <typename T, typename TOffset>
+double DomainDecomposition<T, TOffset>::meanImbalance() const{
+    return _steps > 0 ? _imbalanceSum / _steps : 1;
+}
+
+/**
+ * @brief Average number of bodies a domain received per step, ghost particles and cells
+*/
+template <typename T, typename TOffset>
+double DomainDecomposition<T, TOffset>::meanImportedBodies() const{
+    return _steps > 0 ? _importedSum / _steps : 0;
+}
+
+/**
+ * @brief Cut the particles of order[begin, end[ into count domains starting at first
+ * @param begin First position in the order of the domains
+ * @param end Last position (excluded)
+ * @param first First domain
+ * @param count Number of domains
+ * @param split Node of the bisection
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::bisect(size_t begin, size_t end, uint first, uint count, size_t split){
+    double lo[3] = {INFINITY, INFINITY, INFINITY};
+    double hi[3] = {-INFINITY, -INFINITY, -INFINITY};
+    for (size_t k = begin; k < end; k++){
+        uint32_t i = _order[k];
+        double position[3] = {(double) _x[i], (double) _y[i], (double) _z[i]};
+        for (int a = 0; a < 3; a++){
+            lo[a] = std::min(lo[a], position[a]);
+            hi[a] = std::max(hi[a], position[a]);
+        }
+    }
+
+    if (count == 1){
+        _domainStart[first] = begin;
+        std::copy(lo, lo + 3, _lo + 3 * first);
+        std::copy(hi, hi + 3, _hi + 3 * first);
+        return;
+    }
+
+    // The longest side is cut where the first half of the domains gets its share of the cost
+    int axis = 0;
+    for (int a = 1; a < 3; a++){
+        if (hi[a] - lo[a] > hi[axis] - lo[axis]){
+            axis = a;
+        }
+    }
+    const T* coordinate = axis == 0 ? _x : axis == 1 ? _y : _z;
+    auto below = [&](uint32_t a, uint32_t b){
+        return coordinate[a] < coordinate[b];
+    };
+
+    uint left = count / 2;
+    double total = 0;
+    for (size_t k = begin; k < end; k++){
+        total += _weights[_order[k]];
+    }
+    double target = total * left / count;
+
+    // Weighted selection instead of a sort: the first half gets the particles taken in order along the axis while
+    // their weight stays within the target. [begin, from[ is already in it and holds the weight sum, the cut being
+    // in [from, to], and everything from to onwards lies after it along the axis
+    size_t from = begin;
+    size_t to = end;
+    double sum = 0;
+    while (from < to){
+        size_t pivot = from + (to - from) / 2;
+        std::nth_element(_order + from, _order + pivot, _order + to, below);
+        double before = 0;
+        for (size_t k = from; k < pivot; k++){
+            before += _weights[_order[k]];
+        }
+        if (sum + before + _weights[_order[pivot]] <= target){
+            sum += before + _weights[_order[pivot]];
+            from = pivot + 1;
+        }
+        else {
+            to = pivot;
+        }
+    }
+    size_t middle = from;
+
+    _splits[split].axis = axis;
+    _splits[split].value = middle < end ? coordinate[_order[middle]] : (begin < end ? hi[axis] : 0);
+    bisect(begin, middle, first, left, 2 * split + 1);
+    bisect(middle, end, first + left, count - left, 2 * split + 2);
+}
+
+/**
+ * @brief Domain of the last bisection a position falls in
+ * @param position The position
+*/
+template <typename T, typename TOffset>
+uint DomainDecomposition<T, TOffset>::locate(const double position[3]) const{
+    uint first = 0;
+    uint count = _nbDomains;
+    size_t split = 0;
+    while (count > 1){
+        uint left = count / 2;
+        if (position[_splits[split].axis] < _splits[split].value){
+            count = left;
+            split = 2 * split + 1;
+        }
+        else {
+            first += left;
+            count -= left;
+            split = 2 * split + 2;
+        }
+    }
+    return first;
+}
+
+/**
+ * @brief Send a command to every worker and wait for their answers
+ * @param command The command
+ * @return false if a worker did not answer
+*/
+template <typename T, typename TOffset>
+bool DomainDecomposition<T, TOffset>::broadcast(Command command){
+    uint32_t message = command;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (int socket : _sockets){
+        if (!writeAll(socket, &message, sizeof(message))){
+            return false;
+        }
+    }
+    for (uint d = 0; d < _nbDomains; d++){
+        double seconds;
+        if (!readAll(_sockets[d], &seconds, sizeof(seconds))){
+            return false;
+        }
+        _cost[d] += seconds;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return true;
+}
+
+/**
+ * @brief Loop of a worker process, never returns
+ * @param domain Domain of the worker
+ * @param socket Its end of the socket
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::workerMain(uint domain, int socket){
+    // Stopped by the coordinator, or when it goes away and the socket closes
+    std::signal(SIGINT, SIG_IGN);
+
+    Octree<T, TOffset> domain_tree;
+    Octree<T, TOffset> full_tree;
+    WorkerArrays arrays;
+    while (true){
+        uint32_t command;
+        if (!readAll(socket, &command, sizeof(command)) || command == COMMAND_STOP){
+            _exit(0);
+        }
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto start = std::chrono::steady_clock::now();
+        if (command == COMMAND_EXPORT){
+            exportBodies(domain, domain_tree, arrays);
+        }
+        else {
+            computeDomain(domain, full_tree, arrays);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!writeAll(socket, &seconds, sizeof(seconds))){
+            _exit(0);
+        }
+    }
+}
+
+/**
+ * @brief Worker side of COMMAND_EXPORT: gather the particles of the domain, build their tree and write
+ *        the bodies each other domain needs
+ * @param domain Domain of the worker
+ * @param tree Tree of the domain
+ * @param arrays Receive the particles of the domain
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::exportBodies(uint domain, Octree<T, TOffset>& tree, WorkerArrays& arrays){
+    size_t begin = _domainStart[domain];
+    size_t n = _domainStart[domain + 1] - begin;
+    arrays.x.resize(n);
+    arrays.y.resize(n);
+    arrays.z.resize(n);
+    arrays.mass.resize(n);
+    for (size_t k = 0; k < n; k++){
+        uint32_t i = _order[begin + k];
+        arrays.x[k] = _x[i];
+        arrays.y[k] = _y[i];
+        arrays.z[k] = _z[i];
+        arrays.mass[k] = _mass[i];
+    }
+    tree.update(arrays.x.data(), arrays.y.data(), arrays.z.data(), arrays.mass.data(), arrays.mass.data(), n);
+
+    size_t cursor = (_nbDomains - 1) * begin;
+    for (uint other = 0; other < _nbDomains; other++){
+        uint64_t& start = _exportStart[domain * _nbDomains + other];
+        start = cursor;
+        if (other != domain && n > 0 && _domainStart[other + 1] > _domainStart[other]){
+            T lo[3];
+            T hi[3];
+            for (int a = 0; a < 3; a++){
+                lo[a] = _lo[3 * other + a];
+                hi[a] = _hi[3 * other + a];
+            }
+            tree.forEachSummary(lo, hi, [&](TOffset mass, T x, T y, T z){
+                _bodies[cursor++] = Body {x, y, z, mass};
+            }, [&](uint32_t k){
+                _bodies[cursor++] = Body {arrays.x[k], arrays.y[k], arrays.z[k], arrays.mass[k]};
+            });
+        }
+        _exportCount[domain * _nbDomains + other] = cursor - start;
+    }
+}
+
+/**
+ * @brief Worker side of COMMAND_COMPUTE: add the bodies received to the particles of the domain, and compute
+ *        the accelerations of the particles on the tree of both
+ * @param domain Domain of the worker
+ * @param tree Tree of the particles and of the bodies
+ * @param arrays Particles of the domain, the bodies being appended
+*/
+template <typename T, typename TOffset>
+void DomainDecomposition<T, TOffset>::computeDomain(uint domain, Octree<T, TOffset>& tree, WorkerArrays& arrays){
+    size_t begin = _domainStart[domain];
+    size_t n = _domainStart[domain + 1] - begin;
+    for (uint other = 0; other < _nbDomains; other++){
+        const Body* bodies = _bodies + _exportStart[other * _nbDomains + domain];
+        uint64_t count = other != domain ? _exportCount[other * _nbDomains + domain] : 0;
+        for (uint64_t b = 0; b < count; b++){
+            arrays.x.push_back(bodies[b].x);
+            arrays.y.push_back(bodies[b].y);
+            arrays.z.push_back(bodies[b].z);
+            arrays.mass.push_back(bodies[b].mass);
+        }
+    }
+
+    // The bodies received, after the n particles of the domain, only act on them
+    size_t total = arrays.x.size();
+    arrays.ax.resize(n);
+    arrays.ay.resize(n);
+    arrays.az.resize(n);
+    arrays.phi.resize(n);
+    Softening<TOffset> softening((SofteningKernel) _header->kernel, _header->softening);
+    tree.update(arrays.x.data(), arrays.y.data(), arrays.z.data(), arrays.mass.data(), arrays.mass.data(), total);
+    tree.computeAccelerations(_header->G, softening, arrays.ax.data(), arrays.ay.data(), arrays.az.data(),
+                              _header->potential ? arrays.phi.data() : nullptr, 0, SIZE_MAX, nullptr, n);
+
+    for (size_t k = 0; k < n; k++){
+        uint32_t i = _order[begin + k];
+        _ax[i] = arrays.ax[k];
+        _ay[i] = arrays.ay[k];
+        _az[i] = arrays.az[k];
+        if (_header->potential){
+            _phi[i] = arrays.phi[k];
+        }
+    }
+}
+
+template class DomainDecomposition<float>;
+template class DomainDecomposition<double>;
+template class DomainDecomposition<double, float>;
@@ -0,0 +1,120 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <DualSphereSet.hpp>
+
+/**
+ * @brief Constructor, the origin is (0, 0, 0)
+*/
+template <typename T>
+DualSphereSet<T>::DualSphereSet()
+    : _origin {0, 0, 0}
+    {}
+
+/**
+ * @brief Set the point the coordinates are taken relative to. Contacts do not depend on it,
+ *        but choosing it close to the spheres keeps the ei coefficients small, which matters in float
+ * @param x The x coordinate of the origin
+ * @param y The y coordinate of the origin
+ * @param z The z coordinate of the origin
+*/
+template <typename T>
+void DualSphereSet<T>::setOrigin(double x, double y, double z){
+    _origin[0] = x;
+    _origin[1] = y;
+    _origin[2] = z;
+}
+
+/**
+ * @brief Change the number of spheres of the set
+ * @param n The new number of spheres
+*/
+template <typename T>
+void DualSphereSet<T>::resize(size_t n){
+    _e1.resize(n);
+    _e2.resize(n);
+    _e3.resize(n);
+    _ei.resize(n);
+    _radius.resize(n);
+}
+
+/**
+ * @brief Number of spheres in the set
+*/
+template <typename T>
+size_t DualSphereSet<T>::size() const{
+    return _radius.size();
+}
+
+/**
+ * @brief Set a sphere from its center and its radius
+ * @param i Index of the sphere
+ * @param x The x coordinate of the center
+ * @param y The y coordinate of the center
+ * @param z The z coordinate of the center
+ * @param radius The radius of the sphere
+*/
+template <typename T>
+void DualSphereSet<T>::setSphere(size_t i, double x, double y, double z, double radius){
+    // Same coefficients as c3ga::point(x, y, z) - 0.5 radius^2 ei
+    x -= _origin[0];
+    y -= _origin[1];
+    z -= _origin[2];
+    _e1[i] = x;
+    _e2[i] = y;
+    _e3[i] = z;
+    _ei[i] = 0.5 * (x * x + y * y + z * z - radius * radius);
+    _radius[i] = radius;
+}
+
+/**
+ * @brief Set a sphere from a c3ga dual sphere
+ * @param i Index of the sphere
+ * @param dualSphere The dual sphere, its e0 coefficient must not be 0
+ * @param radius The radius of the sphere
+*/
+template <typename T>
+void DualSphereSet<T>::setSphere(size_t i, const c3ga::Mvec<double>& dualSphere, double radius){
+    double w = dualSphere[c3ga::E0];
+    setSphere(i, dualSphere[c3ga::E1] / w, dualSphere[c3ga::E2] / w, dualSphere[c3ga::E3] / w, radius);
+}
+
+/**
+ * @brief Inner product s_i.s_j of two spheres of the set
+ * @param i Index of the first sphere
+ * @param j Index of the second sphere
+*/
+template <typename T>
+T DualSphereSet<T>::innerProduct(size_t i, size_t j) const{
+    // c3ga metric: e1, e2, e3 are orthonormal and e0.ei = -1, the e0 coefficients being 1
+    return _e1[i] * _e1[j] + _e2[i] * _e2[j] + _e3[i] * _e3[j] - _ei[i] - _ei[j];
+}
+
+/**
+ * @brief Evaluate the contact predicate on a list of candidate pairs
+ * @param first Index of the first sphere of each pair
+ * @param second Index of the second sphere of each pair
+ * @param nb_pairs The number of pairs
+ * @param in_contact Array receiving 1 for each pair in contact, 0 otherwise
+*/
+template <typename T>
+void DualSphereSet<T>::testContacts(const uint32_t* first, const uint32_t* second, size_t nb_pairs, uint8_t* in_contact) const{
+    const T* e1 = _e1.data();
+    const T* e2 = _e2.data();
+    const T* e3 = _e3.data();
+    const T* ei = _ei.data();
+    const T* radius = _radius.data();
+
+    // Branchless body so that the compiler can vectorize the gathers
+    for (size_t k = 0; k < nb_pairs; k++){
+        uint32_t i = first[k];
+        uint32_t j = second[k];
+        T inner = e1[i] * e1[j] + e2[i] * e2[j] + e3[i] * e3[j] - ei[i] - ei[j];
+        in_contact[k] = inner >= -radius[i] * radius[j];
+    }
+}
+
+template class DualSphereSet<float>;
+template class DualSphereSet<double>;
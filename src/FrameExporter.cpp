@@ -0,0 +1,258 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <FrameExporter.hpp>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+
+/**
+ * @brief Constructor, nothing is written until open() is called
+*/
+FrameExporter::FrameExporter()
+    : _format {FRAME_PNG}
+    , _width {0}
+    , _height {0}
+    , _file {NULL}
+    , _pipe {false}
+    , _stop {false}
+    , _offered {0}
+    , _published {0}
+    , _nextFrame {0}
+    , _nextWrite {0}
+    , _framesWritten {0}
+    , _framesDropped {0}
+    {}
+
+/**
+ * @brief Destructor, closes the output
+*/
+FrameExporter::~FrameExporter(){
+    close();
+}
+
+/**
+ * @brief Start the encoder threads. The format follows the path: a pattern ending in ".png" gives one PNG per
+ *        frame ("frames/%05d.png"), a path starting with '|' pipes raw RGB frames to a command
+ *        ("|ffmpeg -f rawvideo -pix_fmt rgb24 -s 1200x800 -i - out.mp4"), any other path is a raw RGB file
+ * @param path Pattern, command or path of the output
+ * @param width Width of the frames
+ * @param height Height of the frames
+ * @param options Which frames are exported and how
+ * @return false if the output could not be created
+*/
+bool FrameExporter::open(const char* path, uint width, uint height, const FrameExportOptions& options){
+    close();
+
+    size_t length = std::strlen(path);
+    _pipe = path[0] == '|';
+    if (!_pipe && length >= 4 && std::strcmp(path + length - 4, ".png") == 0){
+        _format = FRAME_PNG;
+        _pattern = path;
+        // Initialized once here rather than by the first frames of each encoder thread
+        if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)){
+            fprintf(stderr, "Couldn't initialize SDL_image! SDL_Error: %s\n", IMG_GetError());
+            return false;
+        }
+    }
+    else {
+        _format = FRAME_RAW_RGB;
+        _file = _pipe ? popen(path + 1, "w") : fopen(path, "wb");
+        if (_file == NULL){
+            fprintf(stderr, "Could not create the export output %s\n", path);
+            return false;
+        }
+        setvbuf(_file, NULL, _IOFBF, 1 << 20);
+        if (_pipe){
+            // A command that exits early makes the writes fail instead of killing the simulation
+            std::signal(SIGPIPE, SIG_IGN);
+        }
+    }
+
+    _options = options;
+    _options.exportEvery = std::max(1u, _options.exportEvery);
+    _options.queueCapacity = std::max(1u, _options.queueCapacity);
+    _width = width;
+    _height = height;
+
+    std::vector<Slot>(_options.queueCapacity).swap(_slots);
+    for (Slot& slot : _slots){
+        slot.pixels.assign((size_t) width * height, 0);
+    }
+    _offered = 0;
+    _published = 0;
+    _nextFrame = 0;
+    _nextWrite = 0;
+    _framesWritten = 0;
+    _framesDropped = 0;
+
+    _stop = false;
+    uint nb_threads = std::max(1u, _options.nbThreads);
+    for (uint t = 0; t < nb_threads; t++){
+        _threads.emplace_back(&FrameExporter::encoderLoop, this);
+    }
+    return true;
+}
+
+/**
+ * @brief Hand the last frame drawn by a rasterizer to the encoders, if the frame is sampled.
+ *        Its pixel buffer is exchanged with a free one, that the next render overwrites.
+ *        Never blocks unless the options ask to wait
+ * @param rasterizer The rasterizer, of the size given to open()
+ * @return false if the frame was dropped because the queue was full
+*/
+bool FrameExporter::record(Rasterizer& rasterizer){
+    if (!isOpen() || _offered++ % _options.exportEvery != 0){
+        return true;
+    }
+
+    // Only this thread publishes, and the previous frame of the slot is the one queueCapacity frames earlier
+    std::unique_lock<std::mutex> lock(_mutex);
+    uint64_t frame = _published;
+    Slot& slot = _slots[frame % _slots.size()];
+    if (slot.frame != -1){
+        if (!_options.wait){
+            _framesDropped++;
+            return false;
+        }
+        _slotFree.wait(lock, [&]{ return slot.frame == -1; });
+    }
+    lock.unlock();
+
+    // No encoder touches a free slot
+    rasterizer.swapPixels(slot.pixels);
+    lock.lock();
+    slot.frame = frame;
+    _published = frame + 1;
+    lock.unlock();
+    _frameReady.notify_all();
+    return true;
+}
+
+/**
+ * @brief Encode the frames still queued, stop the encoder threads and close the output
+*/
+void FrameExporter::close(){
+    if (!isOpen()){
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _frameReady.notify_all();
+    for (std::thread& thread : _threads){
+        thread.join();
+    }
+    _threads.clear();
+
+    if (_file != NULL){
+        if (_pipe){
+            pclose(_file);
+        }
+        else {
+            fclose(_file);
+        }
+        _file = NULL;
+    }
+    std::vector<Slot>().swap(_slots);
+}
+
+/**
+ * @brief Whether an output is open
+*/
+bool FrameExporter::isOpen() const{
+    return !_threads.empty();
+}
+
+/**
+ * @brief Format of the output
+*/
+FrameFormat FrameExporter::format() const{
+    return _format;
+}
+
+/**
+ * @brief Number of frames written so far
+*/
+uint64_t FrameExporter::framesWritten() const{
+    return _framesWritten;
+}
+
+/**
+ * @brief Number of frames dropped because the queue was full
+*/
+uint64_t FrameExporter::framesDropped() const{
+    return _framesDropped;
+}
+
+/**
+ * @brief Loop of an encoder thread: take the next frame number, wait for it, encode it, until close() is called
+*/
+void FrameExporter::encoderLoop(){
+    std::vector<uint8_t> rgb;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true){
+        uint64_t frame = _nextFrame++;
+        Slot& slot = _slots[frame % _slots.size()];
+        // Leave once stopped, unless the frame was published before the stop
+        _frameReady.wait(lock, [&]{ return slot.frame == (int64_t) frame || (_stop && frame >= _published); });
+        if (slot.frame != (int64_t) frame){
+            return;
+        }
+
+        lock.unlock();
+        encode(slot.pixels, frame, rgb);
+        lock.lock();
+        slot.frame = -1;
+        _slotFree.notify_one();
+    }
+}
+
+/**
+ * @brief Write a frame to the output
+ * @param pixels ARGB pixels of the frame
+ * @param frame Number of the frame among the exported ones
+ * @param rgb Buffer of the thread for the raw frames
+*/
+void FrameExporter::encode(const std::vector<uint32_t>& pixels, uint64_t frame, std::vector<uint8_t>& rgb){
+    if (_format == FRAME_PNG){
+        char name[4096];
+        snprintf(name, sizeof(name), _pattern.c_str(), (int) frame);
+        SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom((void*) pixels.data(), _width, _height, 32,
+                                                                  _width * sizeof(uint32_t), SDL_PIXELFORMAT_ARGB8888);
+        if (surface == NULL || IMG_SavePNG(surface, name) != 0){
+            fprintf(stderr, "Could not write the frame %s: %s\n", name, IMG_GetError());
+        }
+        else {
+            _framesWritten++;
+        }
+        SDL_FreeSurface(surface);
+        return;
+    }
+
+    size_t n = (size_t) _width * _height;
+    rgb.resize(3 * n);
+    for (size_t i = 0; i < n; i++){
+        rgb[3 * i] = pixels[i] >> 16;
+        rgb[3 * i + 1] = pixels[i] >> 8;
+        rgb[3 * i + 2] = pixels[i];
+    }
+
+    // Converted in parallel, appended in order
+    std::unique_lock<std::mutex> lock(_mutex);
+    _frameWritten.wait(lock, [&]{ return _nextWrite == frame; });
+    lock.unlock();
+    if (fwrite(rgb.data(), 1, rgb.size(), _file) == rgb.size()){
+        _framesWritten++;
+    }
+    lock.lock();
+    _nextWrite = frame + 1;
+    lock.unlock();
+    _frameWritten.notify_all();
+}
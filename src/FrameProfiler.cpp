@@ -0,0 +1,229 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <FrameProfiler.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Constructor
+ * @param capacity Number of frames kept, the oldest ones are overwritten
+*/
+FrameProfiler::FrameProfiler(size_t capacity)
+    : _frames(capacity == 0 ? 1 : capacity)
+    , _published {0}
+    , _current {}
+    {}
+
+/**
+ * @brief Current time of the steady clock, in nanoseconds
+*/
+uint64_t FrameProfiler::now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Name of a phase, as shown in traces
+ * @param phase The phase
+*/
+const char* FrameProfiler::phaseName(FramePhase phase){
+    switch (phase){
+        case PHASE_GRAVITY: return "applyGravity";
+        case PHASE_DRAW: return "draw_particles";
+        case PHASE_PRESENT: return "update_window";
+        case PHASE_MOVE: return "updateParticlesPosition";
+        case PHASE_COLLISION: return "applyCollision";
+        case PHASE_SNAPSHOT: return "publishSnapshot";
+        case PHASE_SLEEP: return "nanosleep";
+        default: return "unknown";
+    }
+}
+
+/**
+ * @brief Start recording a new frame
+*/
+void FrameProfiler::beginFrame(){
+    std::memset(&_current, 0, sizeof(_current));
+    _current.index = _published.load(std::memory_order_relaxed);
+    _current.begin = now();
+}
+
+/**
+ * @brief Publish the frame being recorded in the ring buffer
+*/
+void FrameProfiler::endFrame(){
+    _current.end = now();
+    uint64_t published = _published.load(std::memory_order_relaxed);
+    Slot& slot = _frames[published % _frames.size()];
+
+    // Readers of the frame this slot held see an odd sequence, or a different one after their copy
+    uint64_t words[sizeof(FrameRecord) / sizeof(uint64_t)];
+    std::memcpy(words, &_current, sizeof(FrameRecord));
+    slot.sequence.store(2 * published + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t k = 0; k < sizeof(FrameRecord) / sizeof(uint64_t); k++){
+        slot.words[k].store(words[k], std::memory_order_relaxed);
+    }
+    slot.sequence.store(2 * published + 2, std::memory_order_release);
+    _published.store(published + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Mark the start of a phase of the current frame
+ * @param phase The phase
+*/
+void FrameProfiler::beginPhase(FramePhase phase){
+    _current.phaseBegin[phase] = now();
+}
+
+/**
+ * @brief Mark the end of a phase of the current frame
+ * @param phase The phase
+*/
+void FrameProfiler::endPhase(FramePhase phase){
+    _current.phaseEnd[phase] = now();
+}
+
+/**
+ * @brief Number of frames published since the start
+*/
+uint64_t FrameProfiler::frameCount() const{
+    return _published.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Number of frames kept in the ring buffer
+*/
+size_t FrameProfiler::capacity() const{
+    return _frames.size();
+}
+
+/**
+ * @brief Copy a published frame
+ * @param index Number of the frame, between frameCount() - capacity() and frameCount() - 1
+ * @param frame Receives the frame
+ * @return false if the frame is not (or no longer) in the ring buffer
+*/
+bool FrameProfiler::getFrame(uint64_t index, FrameRecord& frame) const{
+    uint64_t published = _published.load(std::memory_order_acquire);
+    if (index >= published || published - index > _frames.size()){
+        return false;
+    }
+
+    // The slot holds the frame from before the copy to after it only if its sequence did not move
+    const Slot& slot = _frames[index % _frames.size()];
+    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (sequence != 2 * index + 2){
+        return false;
+    }
+    uint64_t words[sizeof(FrameRecord) / sizeof(uint64_t)];
+    for (size_t k = 0; k < sizeof(FrameRecord) / sizeof(uint64_t); k++){
+        words[k] = slot.words[k].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != sequence){
+        return false;
+    }
+    std::memcpy(&frame, words, sizeof(FrameRecord));
+    return true;
+}
+
+/**
+ * @brief Average duration of a phase over the last frames, in milliseconds
+ * @param phase The phase
+ * @param nb_frames The number of frames to average
+*/
+double FrameProfiler::averagePhaseDuration(FramePhase phase, size_t nb_frames) const{
+    uint64_t published = frameCount();
+    uint64_t first = published > nb_frames ? published - nb_frames : 0;
+
+    FrameRecord frame;
+    uint64_t total = 0;
+    uint64_t count = 0;
+    for (uint64_t i = first; i < published; i++){
+        if (getFrame(i, frame)){
+            total += frame.phaseEnd[phase] - frame.phaseBegin[phase];
+            count++;
+        }
+    }
+    return count == 0 ? 0 : (double) total / count / 1e6;
+}
+
+/**
+ * @brief Write the frames kept in the ring buffer as a Chrome trace-event JSON file (chrome://tracing, Perfetto)
+ * @param path Path of the file to write
+ * @param other Profiler of another thread written next to this one as a second track, ignored if null
+ * @return false if the file could not be written
+*/
+bool FrameProfiler::writeChromeTrace(const char* path, const FrameProfiler* other) const{
+    FILE* file = fopen(path, "w");
+    if (file == NULL){
+        fprintf(stderr, "Could not open the trace file %s\n", path);
+        return false;
+    }
+
+    // Complete events ("ph": "X"), timestamps in microseconds
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first_event = true;
+    writeEvents(file, 0, first_event);
+    if (other != nullptr){
+        other->writeEvents(file, 1, first_event);
+    }
+    fprintf(file, "\n]}\n");
+
+    bool ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Write the frames kept in the ring buffer as trace events
+ * @param file The file being written
+ * @param tid The track of the events
+ * @param first_event Whether no event was written yet, updated
+*/
+void FrameProfiler::writeEvents(FILE* file, int tid, bool& first_event) const{
+    uint64_t published = frameCount();
+    uint64_t first = published > _frames.size() ? published - _frames.size() : 0;
+
+    FrameRecord frame;
+    for (uint64_t i = first; i < published; i++){
+        if (!getFrame(i, frame)){
+            continue;
+        }
+
+        fprintf(file, "%s{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"index\":%llu}}",
+                first_event ? "" : ",\n", tid, frame.begin / 1e3, (frame.end - frame.begin) / 1e3, (unsigned long long) frame.index);
+        first_event = false;
+
+        for (int p = 0; p < PHASE_COUNT; p++){
+            if (frame.phaseEnd[p] <= frame.phaseBegin[p]){
+                continue;
+            }
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    phaseName((FramePhase) p), tid, frame.phaseBegin[p] / 1e3, (frame.phaseEnd[p] - frame.phaseBegin[p]) / 1e3);
+        }
+    }
+}
+
+/**
+ * @brief Constructor, starts the phase
+ * @param profiler The profiler recording the phase
+ * @param phase The phase
+*/
+ProfileScope::ProfileScope(FrameProfiler& profiler, FramePhase phase)
+    : _profiler {profiler}
+    , _phase {phase}
+    {
+        _profiler.beginPhase(_phase);
+    }
+
+/**
+ * @brief Destructor, ends the phase
+*/
+ProfileScope::~ProfileScope(){
+    _profiler.endPhase(_phase);
+}
@@ -0,0 +1,142 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <NumaTopology.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <sched.h>
+#include <unistd.h>
+
+/**
+ * @brief Read the topology of the machine
+*/
+NumaTopology NumaTopology::detect(){
+    NumaTopology topology;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            CPU_SET(cpu, &allowed);
+        }
+    }
+
+    DIR* directory = opendir("/sys/devices/system/node");
+    if (directory != NULL){
+        struct dirent* item;
+        while ((item = readdir(directory)) != NULL){
+            if (std::strncmp(item->d_name, "node", 4) != 0 || item->d_name[4] < '0' || item->d_name[4] > '9'){
+                continue;
+            }
+            NumaNode node;
+            node.id = std::atoi(item->d_name + 4);
+
+            // A list of ranges, "0-7,16-23"
+            char path[256];
+            char line[4096];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node.id);
+            FILE* file = fopen(path, "r");
+            if (file != NULL){
+                if (fgets(line, sizeof(line), file) != NULL){
+                    for (char* range = std::strtok(line, ",\n"); range != NULL; range = std::strtok(NULL, ",\n")){
+                        char* end;
+                        int first = std::strtol(range, &end, 10);
+                        int last = *end == '-' ? std::strtol(end + 1, NULL, 10) : first;
+                        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++){
+                            if (CPU_ISSET(cpu, &allowed)){
+                                node.cpus.push_back(cpu);
+                            }
+                        }
+                    }
+                }
+                fclose(file);
+            }
+
+            // "Node 0 MemTotal:       131072000 kB"
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node.id);
+            file = fopen(path, "r");
+            if (file != NULL){
+                while (fgets(line, sizeof(line), file) != NULL){
+                    char* total = std::strstr(line, "MemTotal:");
+                    if (total != NULL){
+                        node.memoryBytes = std::strtoull(total + 9, NULL, 10) * 1024;
+                        break;
+                    }
+                }
+                fclose(file);
+            }
+            topology._nodes.push_back(node);
+        }
+        closedir(directory);
+    }
+
+    if (topology._nodes.empty() || topology.cpuCount() == 0){
+        NumaNode node;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++){
+            if (CPU_ISSET(cpu, &allowed)){
+                node.cpus.push_back(cpu);
+            }
+        }
+        node.memoryBytes = (uint64_t) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+        topology._nodes.assign(1, node);
+    }
+
+    std::sort(topology._nodes.begin(), topology._nodes.end(), [](const NumaNode& a, const NumaNode& b){
+        return a.id < b.id;
+    });
+    return topology;
+}
+
+/**
+ * @brief Nodes of the machine, by increasing identifier
+*/
+const std::vector<NumaNode>& NumaTopology::nodes() const{
+    return _nodes;
+}
+
+/**
+ * @brief Number of CPUs the process may run on
+*/
+size_t NumaTopology::cpuCount() const{
+    size_t count = 0;
+    for (const NumaNode& node : _nodes){
+        count += node.cpus.size();
+    }
+    return count;
+}
+
+/**
+ * @brief Write the nodes, their CPUs and their memory
+ * @param out The stream written to
+*/
+void NumaTopology::print(FILE* out) const{
+    fprintf(out, "NUMA: %zu node%s, %zu CPU%s\n", _nodes.size(), _nodes.size() > 1 ? "s" : "", cpuCount(), cpuCount() > 1 ? "s" : "");
+    for (const NumaNode& node : _nodes){
+        fprintf(out, "  node %d: %zu CPU%s (", node.id, node.cpus.size(), node.cpus.size() > 1 ? "s" : "");
+        printCpus(out, node.cpus);
+        fprintf(out, "), %.1f GB\n", node.memoryBytes / (1024.0 * 1024.0 * 1024.0));
+    }
+}
+
+/**
+ * @brief Write a list of CPUs as ranges, "0-7,16-23"
+ * @param out The stream written to
+ * @param cpus The CPUs, sorted
+*/
+void NumaTopology::printCpus(FILE* out, const std::vector<int>& cpus){
+    for (size_t k = 0; k < cpus.size(); ){
+        size_t last = k;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1){
+            last++;
+        }
+        fprintf(out, k == 0 ? "%d" : ",%d", cpus[k]);
+        if (last != k){
+            fprintf(out, "-%d", cpus[last]);
+        }
+        k = last + 1;
+    }
+}
@@ -0,0 +1,743 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <Octree.hpp>
+#include <algorithm>
+#include <cmath>
+
+template <typename T, typename TOffset>
+const uint Octree<T, TOffset>::MAX_DEPTH = 32;  // Guards against endless splits when many particles share a position
+
+template <typename T, typename TOffset>
+const double Octree<T, TOffset>::MIN_FILL = 0.5;  // Below it, the tree has at least one useless level
+
+template <typename T, typename TOffset>
+const double Octree<T, TOffset>::ROOT_MARGIN = 1.0 / 16;
+
+template <typename T, typename TOffset>
+const double Octree<T, TOffset>::MAX_GROWTH = 2;
+
+template <typename T, typename TOffset>
+const double Octree<T, TOffset>::MAX_REINSERTED = 1.0 / 32;  // Above it, inserting the particles again costs more than a build
+
+template <typename T, typename TOffset>
+const uint Octree<T, TOffset>::MAX_REFIT_BACKOFF = 64;
+
+/**
+ * @brief Constructor
+ * @param theta Opening angle of the Barnes-Hut approximation, a cell is approximated by its center of mass when size / distance < theta
+ * @param leafCapacity Maximum number of particles in a leaf
+*/
+template <typename T, typename TOffset>
+Octree<T, TOffset>::Octree(TOffset theta, uint leafCapacity)
+    : _origin {0, 0, 0}
+    , _theta {theta}
+    , _leafCapacity {leafCapacity}
+    , _pool {nullptr}
+    , _builtNodes {0}
+    , _refitBackoff {0}
+    , _skippedRefits {0}
+    {}
+
+/**
+ * @brief Build the tree over a set of particles stored as separate arrays
+ * @param x Array of x coordinates
+ * @param y Array of y coordinates
+ * @param z Array of z coordinates
+ * @param mass Array of masses
+ * @param radius Array of radiuses
+ * @param n The number of particles
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::build(const T* x, const T* y, const T* z, const TOffset* mass, const TOffset* radius, size_t n){
+    _stats.builds++;
+    _nodes.clear();
+    resizeEntries(_entries, n);
+    resizeEntries(_scratchEntries, n);
+    _moved.assign(n, 0);
+    if (n == 0){
+        return;
+    }
+
+    // The root is the bounding cube of all the particles
+    T min_p[3] = {x[0], y[0], z[0]};
+    T max_p[3] = {x[0], y[0], z[0]};
+    for (size_t i = 0; i < n; i++){
+        min_p[0] = std::min(min_p[0], x[i]);
+        min_p[1] = std::min(min_p[1], y[i]);
+        min_p[2] = std::min(min_p[2], z[i]);
+        max_p[0] = std::max(max_p[0], x[i]);
+        max_p[1] = std::max(max_p[1], y[i]);
+        max_p[2] = std::max(max_p[2], z[i]);
+    }
+
+    OctreeNode<TOffset> root {};
+    root.halfSize = 0;
+    for (int a = 0; a < 3; a++){
+        _origin[a] = (min_p[a] + max_p[a]) / 2;
+        root.center[a] = 0;
+        root.halfSize = std::max(root.halfSize, (TOffset) ((max_p[a] - min_p[a]) / 2));
+    }
+
+    // Only the offsets to the center of the root are kept, so that TOffset precision is enough far from the origin
+    for (size_t i = 0; i < n; i++){
+        OctreeEntry<TOffset>& entry = _entries[i];
+        entry.x = x[i] - _origin[0];
+        entry.y = y[i] - _origin[1];
+        entry.z = z[i] - _origin[2];
+        entry.mass = mass[i];
+        entry.radius = radius[i];
+        entry.index = i;
+    }
+
+    // Keep the particles on the border strictly inside, with some room for them to move before update() has to rebuild
+    root.halfSize = root.halfSize * (TOffset) (1 + ROOT_MARGIN) + (TOffset) 1e-3;
+    root.begin = 0;
+    root.end = n;
+
+    _nodes.reserve(2 * n / _leafCapacity + 8);
+    _nodes.push_back(root);
+    buildNode(0, 0);
+    _builtNodes = _nodes.size();
+}
+
+/**
+ * @brief Bring the tree up to date with particles that moved since the last update: the moments are refitted bottom-up
+ *        and only the particles that crossed the boundary of their leaf are inserted again.
+ *        Falls back to build() when the number of particles changed, a particle left the root, the particles fill
+ *        less than half of the root, splits and merges doubled the number of nodes since the last build,
+ *        or more than 1/32 of the particles crossed a cell boundary (the next refits are then skipped for a while)
+ * @param x Array of x coordinates
+ * @param y Array of y coordinates
+ * @param z Array of z coordinates
+ * @param mass Array of masses
+ * @param radius Array of radiuses
+ * @param n The number of particles
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::update(const T* x, const T* y, const T* z, const TOffset* mass, const TOffset* radius, size_t n){
+    if (_skippedRefits > 0){
+        _skippedRefits--;
+        build(x, y, z, mass, radius, n);
+        return;
+    }
+    if (_nodes.empty() || n == 0 || n != _entries.size() || _nodes.size() > MAX_GROWTH * _builtNodes){
+        build(x, y, z, mass, radius, n);
+        return;
+    }
+
+    // The entries keep the order of the tree, only this gather reads the particles out of order
+    TOffset min_p[3] = {(TOffset) (x[0] - _origin[0]), (TOffset) (y[0] - _origin[1]), (TOffset) (z[0] - _origin[2])};
+    TOffset max_p[3] = {min_p[0], min_p[1], min_p[2]};
+    for (size_t k = 0; k < n; k++){
+        OctreeEntry<TOffset>& entry = _entries[k];
+        uint32_t i = entry.index;
+        entry.x = x[i] - _origin[0];
+        entry.y = y[i] - _origin[1];
+        entry.z = z[i] - _origin[2];
+        entry.mass = mass[i];
+        entry.radius = radius[i];
+        min_p[0] = std::min(min_p[0], entry.x);
+        min_p[1] = std::min(min_p[1], entry.y);
+        min_p[2] = std::min(min_p[2], entry.z);
+        max_p[0] = std::max(max_p[0], entry.x);
+        max_p[1] = std::max(max_p[1], entry.y);
+        max_p[2] = std::max(max_p[2], entry.z);
+    }
+
+    // Rebuild if a particle left the root, or if the root is much bigger than the particles and wastes levels of the tree
+    TOffset half_size = _nodes[0].halfSize;
+    TOffset extent = 0;
+    bool outside = false;
+    for (int a = 0; a < 3; a++){
+        extent = std::max(extent, max_p[a] - min_p[a]);
+        outside |= min_p[a] < -half_size || max_p[a] >= half_size;
+    }
+    if (outside || extent < MIN_FILL * 2 * half_size){
+        build(x, y, z, mass, radius, n);
+        return;
+    }
+
+    TOffset lo[3] = {-half_size, -half_size, -half_size};
+    TOffset hi[3] = {half_size, half_size, half_size};
+    _escaped.clear();
+    _dirty.assign(_nodes.size(), 0);
+    refitNode(0, lo, hi);
+
+    // Too many particles to insert again costs more than a build: build instead, and skip the refits of the next
+    // updates, twice as many each time it happens in a row
+    if (_escaped.size() > MAX_REINSERTED * n){
+        _refitBackoff = std::min(std::max(1u, 2 * _refitBackoff), MAX_REFIT_BACKOFF);
+        _skippedRefits = _refitBackoff;
+        build(x, y, z, mass, radius, n);
+        return;
+    }
+    _refitBackoff = 0;
+    _stats.refits++;
+    if (_escaped.empty()){
+        return;
+    }
+
+    // Counting sort of the escaped entries by new leaf
+    _targets.resize(_escaped.size());
+    _insertStart.assign(_nodes.size() + 1, 0);
+    for (size_t e = 0; e < _escaped.size(); e++){
+        _targets[e] = findInsertionLeaf(_entries[_escaped[e]]);
+        _insertStart[_targets[e] + 1]++;
+    }
+    for (size_t node = 0; node < _nodes.size(); node++){
+        _insertStart[node + 1] += _insertStart[node];
+    }
+    _inserted.resize(_escaped.size());
+    for (size_t e = 0; e < _escaped.size(); e++){
+        _inserted[_insertStart[_targets[e]]++] = _escaped[e];
+    }
+    // Each start was moved to the end of its leaf, shift them back
+    for (size_t node = _nodes.size(); node > 0; node--){
+        _insertStart[node] = _insertStart[node - 1];
+    }
+    _insertStart[0] = 0;
+    _stats.reinsertedParticles += _escaped.size();
+
+    _oldEntries.swap(_entries);
+    resizeEntries(_entries, n);
+    uint32_t cursor = 0;
+    relayoutNode(0, 0, cursor);
+
+    for (uint32_t k : _escaped){
+        _moved[k] = 0;
+    }
+}
+
+/**
+ * @brief Remove particles from the tree, following the removal of the same particles from the arrays
+ *        (the others keeping their order), so that the next update() can still refit
+ * @param removed Array of flags, non zero for the removed particles
+ * @param n The number of particles before the removal
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::compact(const uint8_t* removed, size_t n){
+    if (_nodes.empty() || n != _entries.size()){
+        return;
+    }
+
+    // New index of each particle
+    _remap.resize(n);
+    uint32_t kept = 0;
+    for (size_t i = 0; i < n; i++){
+        _remap[i] = kept;
+        kept += !removed[i];
+    }
+
+    // The cells keep their order, each range shrinking by its removed particles: position k moves to _positions[k]
+    _positions.resize(n + 1);
+    uint32_t position = 0;
+    for (size_t k = 0; k < n; k++){
+        uint32_t i = _entries[k].index;
+        _positions[k] = position;
+        if (!removed[i]){
+            _entries[position] = _entries[k];
+            _entries[position].index = _remap[i];
+            position++;
+        }
+    }
+    _positions[n] = position;
+
+    for (OctreeNode<TOffset>& node : _nodes){
+        node.begin = _positions[node.begin];
+        node.end = _positions[node.end];
+    }
+
+    _entries.resize(kept);
+    _scratchEntries.resize(kept);
+    _moved.resize(kept);
+}
+
+/**
+ * @brief Split a node into 8 children if it holds too many particles, then compute its mass moments
+ * @param node Index of the node to build
+ * @param depth Depth of the node in the tree
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::buildNode(uint32_t node, uint depth){
+    uint32_t begin = _nodes[node].begin;
+    uint32_t end = _nodes[node].end;
+
+    if (end - begin > _leafCapacity && depth < MAX_DEPTH){
+        TOffset cx = _nodes[node].center[0];
+        TOffset cy = _nodes[node].center[1];
+        TOffset cz = _nodes[node].center[2];
+        TOffset quarter = _nodes[node].halfSize / 2;
+
+        // Counting sort of the entries by octant
+        uint32_t counts[8] = {0};
+        for (uint32_t k = begin; k < end; k++){
+            const OctreeEntry<TOffset>& entry = _entries[k];
+            counts[(entry.x >= cx) | ((entry.y >= cy) << 1) | ((entry.z >= cz) << 2)]++;
+        }
+        uint32_t offsets[8];
+        offsets[0] = begin;
+        for (int c = 1; c < 8; c++){
+            offsets[c] = offsets[c - 1] + counts[c - 1];
+        }
+
+        uint32_t first_child = _nodes.size();
+        for (int c = 0; c < 8; c++){
+            OctreeNode<TOffset> child {};
+            child.center[0] = cx + ((c & 1) ? quarter : -quarter);
+            child.center[1] = cy + ((c & 2) ? quarter : -quarter);
+            child.center[2] = cz + ((c & 4) ? quarter : -quarter);
+            child.halfSize = quarter;
+            child.begin = offsets[c];
+            child.end = offsets[c] + counts[c];
+            _nodes.push_back(child);
+        }
+
+        for (uint32_t k = begin; k < end; k++){
+            const OctreeEntry<TOffset>& entry = _entries[k];
+            _scratchEntries[offsets[(entry.x >= cx) | ((entry.y >= cy) << 1) | ((entry.z >= cz) << 2)]++] = entry;
+        }
+        std::copy(_scratchEntries.data() + begin, _scratchEntries.data() + end, _entries.data() + begin);
+
+        _nodes[node].firstChild = first_child;
+
+        // Children first, then the moments of this node are gathered from theirs
+        for (uint32_t c = first_child; c < first_child + 8; c++){
+            buildNode(c, depth + 1);
+        }
+        gatherChildren(node);
+    }
+    else {
+        _nodes[node].firstChild = 0;
+        computeLeafMoments(node);
+    }
+}
+
+/**
+ * @brief Compute the moments of a leaf from its particles
+ * @param node Index of the leaf
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::computeLeafMoments(uint32_t node){
+    double mass = 0;
+    double com[3] = {0, 0, 0};
+    TOffset max_radius = 0;
+    for (uint32_t k = _nodes[node].begin; k < _nodes[node].end; k++){
+        const OctreeEntry<TOffset>& entry = _entries[k];
+        mass += entry.mass;
+        com[0] += (double) entry.mass * entry.x;
+        com[1] += (double) entry.mass * entry.y;
+        com[2] += (double) entry.mass * entry.z;
+        max_radius = std::max(max_radius, entry.radius);
+    }
+
+    OctreeNode<TOffset>& current = _nodes[node];
+    current.mass = mass;
+    current.maxRadius = max_radius;
+    for (int a = 0; a < 3; a++){
+        current.com[a] = mass > 0 ? com[a] / mass : current.center[a];
+    }
+}
+
+/**
+ * @brief Compute the moments of an internal node from those of its children
+ * @param node Index of the node
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::gatherChildren(uint32_t node){
+    uint32_t first_child = _nodes[node].firstChild;
+    double mass = 0;
+    double com[3] = {0, 0, 0};
+    TOffset max_radius = 0;
+    for (uint32_t c = first_child; c < first_child + 8; c++){
+        const OctreeNode<TOffset>& child = _nodes[c];
+        mass += child.mass;
+        com[0] += (double) child.mass * child.com[0];
+        com[1] += (double) child.mass * child.com[1];
+        com[2] += (double) child.mass * child.com[2];
+        max_radius = std::max(max_radius, child.maxRadius);
+    }
+
+    OctreeNode<TOffset>& current = _nodes[node];
+    current.mass = mass;
+    current.maxRadius = max_radius;
+    for (int a = 0; a < 3; a++){
+        current.com[a] = mass > 0 ? com[a] / mass : current.center[a];
+    }
+}
+
+/**
+ * @brief Refit the moments of a subtree and collect the particles that left their leaf
+ * @param node Index of the node to refit
+ * @param lo Lower bounds of the cell, the planes used to sort the particles into it
+ * @param hi Upper bounds of the cell
+ * @return Whether a particle left a leaf of the subtree
+*/
+template <typename T, typename TOffset>
+bool Octree<T, TOffset>::refitNode(uint32_t node, const TOffset lo[3], const TOffset hi[3]){
+    uint32_t first_child = _nodes[node].firstChild;
+    bool dirty = false;
+
+    if (first_child == 0){
+        // The bounds are copies of the centers of the ancestors, so this is exactly the test used to sort the particles
+        for (uint32_t k = _nodes[node].begin; k < _nodes[node].end; k++){
+            const OctreeEntry<TOffset>& entry = _entries[k];
+            if (entry.x < lo[0] || entry.x >= hi[0] || entry.y < lo[1] || entry.y >= hi[1] || entry.z < lo[2] || entry.z >= hi[2]){
+                _escaped.push_back(k);
+                _moved[k] = 1;
+                dirty = true;
+            }
+        }
+        computeLeafMoments(node);
+        _dirty[node] = dirty;
+        return dirty;
+    }
+
+    const TOffset* center = _nodes[node].center;
+    for (uint32_t c = 0; c < 8; c++){
+        TOffset child_lo[3];
+        TOffset child_hi[3];
+        for (int a = 0; a < 3; a++){
+            bool upper = c & (1 << a);
+            child_lo[a] = upper ? center[a] : lo[a];
+            child_hi[a] = upper ? hi[a] : center[a];
+        }
+        dirty |= refitNode(first_child + c, child_lo, child_hi);
+    }
+    gatherChildren(node);
+    _dirty[node] = dirty;
+    return dirty;
+}
+
+/**
+ * @brief Find the leaf whose cell holds a particle, marking the nodes on the way as changed
+ * @param entry The particle
+*/
+template <typename T, typename TOffset>
+uint32_t Octree<T, TOffset>::findInsertionLeaf(const OctreeEntry<TOffset>& entry){
+    uint32_t node = 0;
+    _dirty[node] = 1;
+    while (_nodes[node].firstChild != 0){
+        const TOffset* center = _nodes[node].center;
+        node = _nodes[node].firstChild + ((entry.x >= center[0]) | ((entry.y >= center[1]) << 1) | ((entry.z >= center[2]) << 2));
+        _dirty[node] = 1;
+    }
+    return node;
+}
+
+/**
+ * @brief Move the entry ranges of a subtree
+ * @param node Index of the root of the subtree
+ * @param shift Number of positions to add, modulo 2^32
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::shiftRanges(uint32_t node, uint32_t shift){
+    _nodes[node].begin += shift;
+    _nodes[node].end += shift;
+    if (_nodes[node].firstChild != 0){
+        for (uint32_t c = 0; c < 8; c++){
+            shiftRanges(_nodes[node].firstChild + c, shift);
+        }
+    }
+}
+
+/**
+ * @brief Lay the entries of a subtree out again, without the particles that left their leaf and with the ones
+ *        that entered it, splitting the leaves that became too full and merging the nodes that became almost empty
+ * @param node Index of the node
+ * @param depth Depth of the node in the tree
+ * @param cursor Position of the next entry
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::relayoutNode(uint32_t node, uint depth, uint32_t& cursor){
+    uint32_t first_child = _nodes[node].firstChild;
+
+    // Untouched subtrees are copied as a block, only their ranges move
+    if (!_dirty[node]){
+        uint32_t begin = _nodes[node].begin;
+        uint32_t end = _nodes[node].end;
+        std::copy(_oldEntries.data() + begin, _oldEntries.data() + end, _entries.data() + cursor);
+        if (cursor != begin){
+            shiftRanges(node, cursor - begin);
+        }
+        cursor += end - begin;
+        return;
+    }
+
+    if (first_child == 0){
+        uint32_t begin = cursor;
+        for (uint32_t k = _nodes[node].begin; k < _nodes[node].end; k++){
+            if (!_moved[k]){
+                _entries[cursor++] = _oldEntries[k];
+            }
+        }
+        bool changed = cursor - begin != _nodes[node].end - _nodes[node].begin;
+        for (uint32_t e = _insertStart[node]; e < _insertStart[node + 1]; e++){
+            _entries[cursor++] = _oldEntries[_inserted[e]];
+            changed = true;
+        }
+
+        _nodes[node].begin = begin;
+        _nodes[node].end = cursor;
+        if (cursor - begin > _leafCapacity && depth < MAX_DEPTH){
+            buildNode(node, depth);
+            _stats.leafSplits++;
+        }
+        else if (changed){
+            computeLeafMoments(node);
+        }
+        return;
+    }
+
+    for (uint32_t c = first_child; c < first_child + 8; c++){
+        relayoutNode(c, depth + 1, cursor);
+    }
+    _nodes[node].begin = _nodes[first_child].begin;
+    _nodes[node].end = _nodes[first_child + 7].end;
+
+    // Children emptied by the particles leaving them are merged back, leaving their nodes unused until the next build.
+    // Waiting for half a leaf avoids splitting and merging the same node over and over
+    bool mergeable = _nodes[node].end - _nodes[node].begin <= _leafCapacity / 2;
+    for (uint32_t c = first_child; c < first_child + 8 && mergeable; c++){
+        mergeable = _nodes[c].firstChild == 0;
+    }
+    if (mergeable){
+        _nodes[node].firstChild = 0;
+        computeLeafMoments(node);
+        _stats.leafMerges++;
+        return;
+    }
+    gatherChildren(node);
+}
+
+/**
+ * @brief Compute the gravitational acceleration of every particle using the Barnes-Hut approximation
+ * @param G The gravitational constant
+ * @param softening Shape of the force at short distance, applied to particles and cells alike
+ * @param ax Array receiving the x component of the accelerations
+ * @param ay Array receiving the y component of the accelerations
+ * @param az Array receiving the z component of the accelerations
+ * @param phi Array receiving the gravitational potential of every particle in the same pass, ignored if null
+ * @param begin First entry whose acceleration is computed, the entries being in the order of the cells
+ * @param end Last entry (excluded), entryCount() by default
+ * @param interactions Array receiving the number of cells and particles that acted on every particle, ignored if null
+ * @param active Only the particles of index below active get an acceleration, the others only act on them
+ * @return The number of interactions evaluated over the range
+*/
+template <typename T, typename TOffset>
+uint64_t Octree<T, TOffset>::computeAccelerations(double G, const Softening<TOffset>& softening, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi,
+                                                  size_t begin, size_t end, uint32_t* interactions, size_t active) const{
+    end = std::min(end, _entries.size());
+    if (_nodes.empty() || begin >= end){
+        return 0;
+    }
+
+    switch (softening.kernel()){
+        case SOFTENING_PLUMMER:
+            if (phi != nullptr){
+                return accumulateAccelerations<SOFTENING_PLUMMER, true>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+            else {
+                return accumulateAccelerations<SOFTENING_PLUMMER, false>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+        case SOFTENING_SPLINE:
+            if (phi != nullptr){
+                return accumulateAccelerations<SOFTENING_SPLINE, true>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+            else {
+                return accumulateAccelerations<SOFTENING_SPLINE, false>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+        default:
+            if (phi != nullptr){
+                return accumulateAccelerations<SOFTENING_NONE, true>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+            else {
+                return accumulateAccelerations<SOFTENING_NONE, false>(G, softening, ax, ay, az, phi, begin, end, interactions, active);
+            }
+    }
+}
+
+/**
+ * @brief Force loop of computeAccelerations(), instantiated once per softening kernel
+ * @tparam K The softening kernel, the same as softening.kernel()
+ * @tparam POTENTIAL Whether the potentials are computed too
+ * @param g The gravitational constant
+ * @param softening Shape of the force at short distance
+ * @param ax Array receiving the x component of the accelerations
+ * @param ay Array receiving the y component of the accelerations
+ * @param az Array receiving the z component of the accelerations
+ * @param phi Array receiving the potentials
+ * @param begin First entry
+ * @param end Last entry (excluded)
+ * @param interactions Array receiving the number of interactions of every particle, ignored if null
+ * @param active Index of the first particle that only acts on the others
+ * @return The number of interactions evaluated
+*/
+template <typename T, typename TOffset>
+template <SofteningKernel K, bool POTENTIAL>
+uint64_t Octree<T, TOffset>::accumulateAccelerations(TOffset g, const Softening<TOffset>& softening, TOffset* ax, TOffset* ay, TOffset* az, TOffset* phi,
+                                                     uint32_t begin, uint32_t end, uint32_t* interactions, size_t active) const{
+    const TOffset theta2 = _theta * _theta;
+    uint64_t total = 0;
+
+    for (uint32_t k = begin; k < end; k++){
+        if (_entries[k].index >= active){
+            continue;
+        }
+        TOffset px = _entries[k].x;
+        TOffset py = _entries[k].y;
+        TOffset pz = _entries[k].z;
+        TOffset acc[3] = {0, 0, 0};
+        TOffset potential = 0;
+        uint32_t count = 0;
+
+        uint32_t stack[8 * 64];
+        uint stack_size = 0;
+        stack[stack_size++] = 0;
+
+        while (stack_size > 0){
+            const OctreeNode<TOffset>& node = _nodes[stack[--stack_size]];
+            if (node.begin == node.end){
+                continue;
+            }
+
+            TOffset dx = node.com[0] - px;
+            TOffset dy = node.com[1] - py;
+            TOffset dz = node.com[2] - pz;
+            TOffset d2 = dx * dx + dy * dy + dz * dz;
+            TOffset size = 2 * node.halfSize;
+
+            if (node.firstChild != 0 && size * size < theta2 * d2){
+                // Far enough: the whole cell acts as a single body
+                count++;
+                TOffset f = g * node.mass * softening.template inverseCube<K>(d2);
+                acc[0] += f * dx;
+                acc[1] += f * dy;
+                acc[2] += f * dz;
+                if (POTENTIAL){
+                    potential -= g * node.mass * softening.template inverseDistance<K>(d2);
+                }
+            }
+            else if (node.firstChild == 0){
+                count += node.end - node.begin - (k >= node.begin && k < node.end);
+                for (uint32_t l = node.begin; l < node.end; l++){
+                    if (l == k){
+                        continue;
+                    }
+                    const OctreeEntry<TOffset>& other = _entries[l];
+                    TOffset ddx = other.x - px;
+                    TOffset ddy = other.y - py;
+                    TOffset ddz = other.z - pz;
+                    TOffset r2 = ddx * ddx + ddy * ddy + ddz * ddz;
+                    TOffset f = g * other.mass * softening.template inverseCube<K>(r2);
+                    acc[0] += f * ddx;
+                    acc[1] += f * ddy;
+                    acc[2] += f * ddz;
+                    if (POTENTIAL){
+                        potential -= g * other.mass * softening.template inverseDistance<K>(r2);
+                    }
+                }
+            }
+            else {
+                for (uint32_t c = 0; c < 8; c++){
+                    stack[stack_size++] = node.firstChild + c;
+                }
+            }
+        }
+
+        uint32_t i = _entries[k].index;
+        ax[i] = acc[0];
+        ay[i] = acc[1];
+        az[i] = acc[2];
+        if (POTENTIAL){
+            phi[i] = potential;
+        }
+        if (interactions != nullptr){
+            interactions[i] = count;
+        }
+        total += count;
+    }
+    return total;
+}
+
+/**
+ * @brief Number of nodes of the tree
+*/
+template <typename T, typename TOffset>
+size_t Octree<T, TOffset>::nodeCount() const{
+    return _nodes.size();
+}
+
+/**
+ * @brief Counters of rebuilds and refits since the creation of the tree
+*/
+template <typename T, typename TOffset>
+const OctreeStats& Octree<T, TOffset>::stats() const{
+    return _stats;
+}
+
+/**
+ * @brief Number of particles in the tree
+*/
+template <typename T, typename TOffset>
+size_t Octree<T, TOffset>::entryCount() const{
+    return _entries.size();
+}
+
+/**
+ * @brief Cut the entries into ranges of the same total cost. The entries being in the order of the cells, each
+ *        range is a piece of the Morton curve through the octants, a compact region of space
+ * @param cost Array of the cost of every particle, by index, a particle costing at least 1
+ * @param parts Number of ranges
+ * @param bounds Receives the parts + 1 bounds of the ranges, the first one 0 and the last one entryCount()
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::partitionEntries(const uint32_t* cost, uint parts, std::vector<size_t>& bounds) const{
+    parts = std::max(1u, parts);
+    uint64_t total = 0;
+    for (size_t k = 0; k < _entries.size(); k++){
+        total += std::max<uint32_t>(1, cost[_entries[k].index]);
+    }
+
+    // Range r ends at the first entry whose cumulative cost reaches r / parts of the total
+    bounds.assign(parts + 1, _entries.size());
+    bounds[0] = 0;
+    uint64_t sum = 0;
+    uint r = 1;
+    for (size_t k = 0; k < _entries.size() && r < parts; k++){
+        sum += std::max<uint32_t>(1, cost[_entries[k].index]);
+        while (r < parts && sum * parts >= total * r){
+            bounds[r++] = k + 1;
+        }
+    }
+}
+
+/**
+ * @brief Place the entries on the NUMA nodes of the workers that compute their accelerations: the entries
+ *        allocated from now on are first written by the owners of their ranges
+ * @param pool The workers, none if null
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::setWorkerPool(WorkerPool* pool){
+    _pool = pool;
+}
+
+/**
+ * @brief Resize an array of entries, its new pages being first written by the workers if there are some
+ * @param entries The array
+ * @param n The new number of entries
+*/
+template <typename T, typename TOffset>
+void Octree<T, TOffset>::resizeEntries(BlockArray<OctreeEntry<TOffset>>& entries, size_t n){
+    bool grown = n > entries.capacity();
+    entries.resize(n);
+    if (grown && _pool != nullptr){
+        _pool->firstTouch(entries.data(), n);
+    }
+}
+
+template class Octree<float>;
+template class Octree<double>;
+template class Octree<double, float>;
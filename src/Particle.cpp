@@ -56,6 +56,9 @@ void Particle::updatePosition(){
 
         Vector<float> distances = {_direction.x - _position.x, _direction.y - _position.y};
         float distance = sqrt(pow(distances.x, 2) + pow(distances.y, 2));
+        if (distance == 0){
+            return;  // Already at its target, no direction to follow
+        }
 
         distances.x /= distance;
         distances.y /= distance;
@@ -87,9 +90,11 @@ void Particle::updatePosition(){
  * @param radius The radius of the particles to create
  * @param w_width The width of the window
  * @param w_height The height of the window
+ * @param seed Seed of the random generator, the same seed gives the same set
 */
-std::vector<Particle> Particle::createParticleSet(uint nb, float radius, uint w_width, uint w_height){
+std::vector<Particle> Particle::createParticleSet(uint64_t nb, float radius, uint w_width, uint w_height, uint64_t seed){
     std::vector<Particle> particles;
+    particles.reserve(nb + 1);
 
     // Adding black hole
 
@@ -105,14 +110,17 @@ std::vector<Particle> Particle::createParticleSet(uint nb, float radius, uint w_
     int spawnAreaY = w_height * 2;
 
     for (size_t i = 0; i < nb; i++){
-        Vector<float> position = {(float) ((rand() % spawnAreaX) - (spawnAreaX / 2) + black_hole_pos.x),
-                                  (float) ((rand() % spawnAreaY) - (spawnAreaY / 2) + black_hole_pos.y)};
+        // One stream per particle, keyed by its index in the set
+        CounterRng rng(seed, i + 1);
+
+        Vector<float> position = {(float) ((int) rng.nextUInt(spawnAreaX) - (spawnAreaX / 2) + black_hole_pos.x),
+                                  (float) ((int) rng.nextUInt(spawnAreaY) - (spawnAreaY / 2) + black_hole_pos.y)};
 
         // TODO Generate random direction in a cleaner way.        
-        Vector<float> direction = {(float) (rand() % w_width * 5000), (float) (rand() % w_height * 5000)};
+        Vector<float> direction = {(float) (rng.nextUInt(w_width) * 5000), (float) (rng.nextUInt(w_height) * 5000)};
 
-        direction.x = (rand() % 2 == 1 ? -direction.x : direction.x);
-        direction.y = (rand() % 2 == 1 ? -direction.y : direction.y);
+        direction.x = (rng.nextUInt(2) == 1 ? -direction.x : direction.x);
+        direction.y = (rng.nextUInt(2) == 1 ? -direction.y : direction.y);
 
         particles.push_back(Particle(position, radius, Vector<float>{3,3}, direction)); // Maybe random speed?
     }
@@ -137,18 +145,21 @@ const double Particle::G = 6.67430 * 800; // The gravitational constant in Newto
  * @brief Compute the gravitational force between two particle using Newton's equation for universal gravitation
  * @param p1 Reference to the first particle
  * @param p2 Reference to the second particle
+ * @param softening Shape of the force at short distance
 */
-double Particle::computeGravitationalForce(Particle& p1, Particle& p2){
+double Particle::computeGravitationalForce(Particle& p1, Particle& p2, const Softening<double>& softening){
     Vector<float> distances = {p1._position.x - p2._position.x, p1._position.y - p2._position.y};
-    float distance = sqrt(pow(distances.x, 2) + pow(distances.y, 2));
-    return distance == 0 ? 0 : (G * p1._radius * p2._radius) / pow(distance, 2);
+    double distance2 = pow(distances.x, 2) + pow(distances.y, 2);
+    // G m1 m2 / d^2 without softening
+    return G * p1._radius * p2._radius * sqrt(distance2) * softening.inverseCube(distance2);
 }
 
 /**
  * @brief Apply the gravity of all the particle on all other particles
  * @param particles Reference to a vector of particle
+ * @param softening Shape of the force at short distance, the plain inverse square law by default
 */
-void Particle::applyGravity(std::vector<Particle>& particles){
+void Particle::applyGravity(std::vector<Particle>& particles, const Softening<double>& softening){
     for (Particle& p : particles){
         Vector<float> total_force = {0, 0};
 
@@ -157,7 +168,7 @@ void Particle::applyGravity(std::vector<Particle>& particles){
             if (&p != &other){ 
 
                 // Distance between the two particles
-                double F = computeGravitationalForce(p, other);
+                double F = computeGravitationalForce(p, other, softening);
 
                 // Vector from p to other
                 Vector<float> force_direction = {other._position.x - p._position.x, other._position.y - p._position.y};
@@ -167,8 +178,13 @@ void Particle::applyGravity(std::vector<Particle>& particles){
             }
         }
 
-        p._speed.x += (total_force.x * p._speed.x) /p._direction.x;
-        p._speed.y += (total_force.y * p._speed.y) /p._direction.y;
+        // The direction is a target point, a null coordinate would give an infinite speed
+        if (p._direction.x != 0){
+            p._speed.x += (total_force.x * p._speed.x) /p._direction.x;
+        }
+        if (p._direction.y != 0){
+            p._speed.y += (total_force.y * p._speed.y) /p._direction.y;
+        }
 
         p._direction.x += total_force.x;
         p._direction.y += total_force.y;
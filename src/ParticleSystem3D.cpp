@@ -0,0 +1,1199 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <ParticleSystem3D.hpp>
+#include <ForEachChunk.hpp>
+#include <algorithm>
+#include <ctime>
+#include <type_traits>
+#include <cstring>
+#include <limits>
+
+// Same scale as the 2D simulation, the radius is used as mass in formulas
+template <typename T, typename TOffset>
+const double ParticleSystem3D<T, TOffset>::G = 6.67430 * 800;
+template <typename T, typename TOffset>
+const TOffset ParticleSystem3D<T, TOffset>::BH_RADIUS = 20;
+template <typename T, typename TOffset>
+const double ParticleSystem3D<T, TOffset>::PAIR_ACCURACY = 0.02;
+template <typename T, typename TOffset>
+const uint ParticleSystem3D<T, TOffset>::MAX_PAIR_SUBSTEPS = 4096;
+
+/**
+ * @brief Create a set of particles with random positions around the fixed black hole,
+ *        including nb particles + the center fixed black hole
+ * @param nb The number of particles to create
+ * @param radius The radius of the particles to create
+ * @param w_width The width of the window
+ * @param w_height The height of the window
+ * @param seed Seed of the random generator, the same seed gives the same set
+*/
+template <typename T, typename TOffset>
+ParticleSystem3D<T, TOffset> ParticleSystem3D<T, TOffset>::createParticleSet(uint64_t nb, TOffset radius, uint w_width, uint w_height, uint64_t seed){
+    SceneParameters parameters;
+    parameters.distribution = SCENE_UNIFORM_BOX;
+    parameters.nbParticles = nb;
+    parameters.radius = radius;
+    parameters.center[0] = (double) w_width / 2;
+    parameters.center[1] = (double) w_height / 2;
+
+    // Same spawn area as in 2D (twice the window), the depth being the smallest side
+    parameters.halfSize[0] = w_width;
+    parameters.halfSize[1] = w_height;
+    parameters.halfSize[2] = std::min(w_width, w_height);
+    parameters.seed = seed;
+
+    return createScene(parameters);
+}
+
+/**
+ * @brief Draw the position and the velocity of a particle, relative to the black hole
+ * @param parameters Description of the scene
+ * @param rng Random stream of the particle
+ * @param G The gravitational constant
+ * @param bh_mass The mass of the black hole
+ * @param softening The softening length of the force
+ * @param position Receives the position
+ * @param velocity Receives the velocity
+*/
+static void sampleParticle(const SceneParameters& parameters, CounterRng& rng, double G, double bh_mass, double softening,
+                           double position[3], double velocity[3]){
+    double scale = parameters.scaleLength;
+    double particles_mass = parameters.nbParticles * parameters.radius;
+
+    switch (parameters.distribution){
+        case SCENE_UNIFORM_BOX: {
+            for (int a = 0; a < 3; a++){
+                position[a] = rng.uniform(-1, 1) * parameters.halfSize[a];
+            }
+
+            // Circular velocity around the z axis of the black hole
+            double dist = std::sqrt(position[0] * position[0] + position[1] * position[1] + softening * softening);
+            double speed = std::sqrt(G * bh_mass / dist);
+            velocity[0] = -position[1] / dist * speed;
+            velocity[1] = position[0] / dist * speed;
+            velocity[2] = 0;
+            break;
+        }
+
+        case SCENE_EXPONENTIAL_DISC: {
+            // R e^(-R) is the density of the sum of two exponential variables
+            double R = -scale * std::log((1 - rng.nextDouble()) * (1 - rng.nextDouble()));
+            double angle = rng.uniform(0, 2 * M_PI);
+            double height = -parameters.scaleHeight * std::log(1 - rng.nextDouble());
+            position[0] = R * std::cos(angle);
+            position[1] = R * std::sin(angle);
+            position[2] = rng.nextUInt(2) ? height : -height;
+
+            // Circular velocity, the disc mass inside R being taken as if it was at the center
+            double enclosed = particles_mass * (1 - (1 + R / scale) * std::exp(-R / scale));
+            double dist = std::sqrt(R * R + softening * softening);
+            double speed = std::sqrt(G * (bh_mass + enclosed) / dist);
+            velocity[0] = -position[1] / dist * speed;
+            velocity[1] = position[0] / dist * speed;
+            velocity[2] = 0;
+            break;
+        }
+
+        case SCENE_PLUMMER_SPHERE: {
+            // Inverse of the cumulative mass M(r) = r^3 / (r^2 + a^2)^(3/2), the outer 1% is dropped
+            double m = rng.uniform(0, 0.99);
+            double cbrt_m = std::cbrt(m);
+            double r = scale * cbrt_m / std::sqrt(1 - cbrt_m * cbrt_m);
+
+            // Speed from the distribution function, by rejection (Aarseth, Henon and Wielen 1974)
+            double q = 0;
+            double t = 0;
+            do {
+                q = rng.nextDouble();
+                t = 1 - q * q;
+            } while (0.1 * rng.nextDouble() > q * q * t * t * t * std::sqrt(t));
+            double escape = std::sqrt(2 * G * particles_mass / scale) / std::sqrt(std::sqrt(1 + r * r / (scale * scale)));
+            double speed = q * escape;
+
+            // Isotropic directions
+            double directions[2][3];
+            for (int d = 0; d < 2; d++){
+                double cos_theta = rng.uniform(-1, 1);
+                double sin_theta = std::sqrt(1 - cos_theta * cos_theta);
+                double phi = rng.uniform(0, 2 * M_PI);
+                directions[d][0] = sin_theta * std::cos(phi);
+                directions[d][1] = sin_theta * std::sin(phi);
+                directions[d][2] = cos_theta;
+            }
+            for (int a = 0; a < 3; a++){
+                position[a] = r * directions[0][a];
+                velocity[a] = speed * directions[1][a];
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Create a scene: the fixed black hole at index 0, then the particles.
+ *        The arrays are allocated once and filled by chunks in parallel, particle i drawing from the random stream i
+ *        so that the scene does not depend on the number of threads
+ * @param parameters Description of the scene
+ * @param pool Workers filling the set, each one writing first the particles it owns, and kept by the set
+ *        (see setWorkerPool()). If null, the set is filled by parameters.nbThreads threads
+*/
+template <typename T, typename TOffset>
+ParticleSystem3D<T, TOffset> ParticleSystem3D<T, TOffset>::createScene(const SceneParameters& parameters, WorkerPool* pool){
+    ParticleSystem3D particles;
+    particles.setWorkerPool(pool);
+    size_t n = (size_t) parameters.nbParticles + 1;
+    particles.resize(n);
+
+    auto fill = [&](size_t begin, size_t end){
+        for (size_t i = std::max<size_t>(1, begin); i < end; i++){
+            CounterRng rng(parameters.seed, i);
+            double position[3];
+            double velocity[3];
+            sampleParticle(parameters, rng, G, BH_RADIUS, GravityParameters().softening, position, velocity);
+            particles.setParticle(i, parameters.center[0] + position[0], parameters.center[1] + position[1], parameters.center[2] + position[2],
+                                  parameters.radius, velocity[0], velocity[1], velocity[2]);
+        }
+    };
+    if (pool != nullptr){
+        // Each worker writes first, and so places, the pages of the particles it owns
+        pool->forEachRange(n, [&](uint, size_t begin, size_t end){
+            fill(begin, end);
+        });
+    }
+    else {
+        forEachChunk(n, 1 << 16, parameters.nbThreads, [&](size_t, size_t begin, size_t end){
+            fill(begin, end);
+        });
+    }
+
+    // Adding black hole, after the first page was placed by its owner
+    particles.setParticle(0, parameters.center[0], parameters.center[1], parameters.center[2], BH_RADIUS, 0, 0, 0, true);
+
+    return particles;
+}
+
+/**
+ * @brief Compute the gravity on worker processes, one per spatial domain, instead of in this process
+ * @param domains The running workers, none if null. If they stop, the gravity goes back to this process
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setDomains(DomainDecomposition<T, TOffset>* domains){
+    _domains = domains;
+    if (_domains != nullptr){
+        _domains->setWorkerPool(_pool);
+    }
+}
+
+/**
+ * @brief Call f(begin, end) on the range of [0, n[ owned by each worker of the pool, or on [0, n[ without a pool
+ * @param n The number of items
+ * @param f The function called on each range
+*/
+template <typename T, typename TOffset>
+template <typename F>
+void ParticleSystem3D<T, TOffset>::forEachOwnedRange(size_t n, F f){
+    if (_pool == nullptr){
+        f(0, n);
+        return;
+    }
+    _pool->forEachRange(n, [&](uint, size_t begin, size_t end){
+        f(begin, end);
+    });
+}
+
+/**
+ * @brief CPU time used by the calling thread, in seconds
+*/
+static double threadSeconds(){
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Compute the accelerations on the octree, on the workers if there are some, counting the interactions
+ *        of every particle and cutting the entries again by cost when a partition is due
+ * @param phi Array receiving the potentials, ignored if null
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::computeBalancedAccelerations(TOffset* phi){
+    size_t n = _octree.entryCount();
+    if (_pool == nullptr){
+        _octree.computeAccelerations(G, _softening, _ax.data(), _ay.data(), _az.data(), phi, 0, n, _cost.data());
+        return;
+    }
+
+    uint workers = _pool->size();
+    if (_balancePeriod == 0){
+        // Each worker walks the tree for the same cells at every step, reading entries it placed on its node
+        _partition.resize(workers + 1);
+        for (uint w = 0; w <= workers; w++){
+            _partition[w] = _pool->rangeBegin(n, w);
+        }
+    }
+    else if (_partition.size() != workers + 1 || _partition[workers] != n || _balancedAt == 0
+             || _balance.steps >= _balancedAt + _balancePeriod){
+        // Particles near the black hole open many more cells than the others: the entries being in the order of
+        // the cells, equal costs make ranges of very different lengths. The first partition has no cost yet, so the
+        // next step cuts again, and merges shift the entries, so a step after merges cuts again too
+        _octree.partitionEntries(_cost.data(), workers, _partition);
+        _balancedAt = _balance.steps;
+        _balance.rebalances++;
+    }
+
+    _stepSeconds.assign(workers, 0);
+    _stepInteractions.assign(workers, 0);
+    _pool->forEachPartition(_partition, [&](uint worker, size_t begin, size_t end){
+        double start = threadSeconds();
+        _stepInteractions[worker] = _octree.computeAccelerations(G, _softening, _ax.data(), _ay.data(), _az.data(), phi, begin, end, _cost.data());
+        _stepSeconds[worker] = threadSeconds() - start;
+    });
+
+    _balance.workerSeconds.resize(workers, 0);
+    _balance.workerInteractions.resize(workers, 0);
+    double slowest = 0;
+    double total = 0;
+    for (uint w = 0; w < workers; w++){
+        _balance.workerSeconds[w] += _stepSeconds[w];
+        _balance.workerInteractions[w] += _stepInteractions[w];
+        slowest = std::max(slowest, _stepSeconds[w]);
+        total += _stepSeconds[w];
+    }
+    _balance.lastImbalance = total > 0 ? slowest * workers / total : 1;
+    _balance.imbalanceSum += _balance.lastImbalance;
+    _balance.steps++;
+}
+
+/**
+ * @brief Change the number of particles, new particles are at the origin with a null radius and get new identifiers
+ * @param n The new number of particles
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::resize(size_t n){
+    _treeCurrent = false;
+    _fixedCurrent = false;
+    _x.resize(n);
+    _y.resize(n);
+    _z.resize(n);
+    _vx.resize(n);
+    _vy.resize(n);
+    _vz.resize(n);
+    _ax.resize(n);
+    _ay.resize(n);
+    _az.resize(n);
+    _radius.resize(n);
+    _fixed.resize(n);
+    _toRemove.resize(n);
+    _cost.resize(n);
+    _regularizedFirst.clear();
+    _regularizedSecond.clear();
+
+    size_t old_size = _id.size();
+    uint64_t first_id = _nextId;
+    _id.resize(n);
+    forEachOwnedRange(n, [&](size_t begin, size_t end){
+        for (size_t i = std::max(begin, old_size); i < end; i++){
+            _id[i] = first_id + (i - old_size);
+        }
+    });
+    _nextId += n > old_size ? n - old_size : 0;
+}
+
+/**
+ * @brief Copy the positions, velocities, radiuses and fixed flags into another set, such as a snapshot read by
+ *        another thread. The arrays are copied by ranges on the workers of this set
+ * @param snapshot The set receiving the copy, resized to this one
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::copyState(ParticleSystem3D& snapshot){
+    size_t n = size();
+    snapshot.resize(n);
+    auto copyRange = [](auto& destination, const auto& source, size_t begin, size_t end){
+        std::memcpy(destination.data() + begin, source.data() + begin, (end - begin) * sizeof(source[0]));
+    };
+    forEachOwnedRange(n, [&](size_t begin, size_t end){
+        copyRange(snapshot._x, _x, begin, end);
+        copyRange(snapshot._y, _y, begin, end);
+        copyRange(snapshot._z, _z, begin, end);
+        copyRange(snapshot._vx, _vx, begin, end);
+        copyRange(snapshot._vy, _vy, begin, end);
+        copyRange(snapshot._vz, _vz, begin, end);
+        copyRange(snapshot._radius, _radius, begin, end);
+        copyRange(snapshot._fixed, _fixed, begin, end);
+    });
+}
+
+/**
+ * @brief Reorder the particles, the particle k of the new order being the particle order[k] of the current one.
+ *        The arrays are gathered in parallel on the workers, and the octree is built again
+ * @param order A permutation of the indices of the particles
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::permute(const uint32_t* order){
+    size_t n = size();
+    // The new pages are first written by the workers, on their nodes
+    auto permuteArray = [&](auto& array){
+        typename std::decay<decltype(array)>::type sorted;
+        sorted.resize(n);
+        gatherArray(sorted.data(), array.data(), order, n, _pool);
+        array.swap(sorted);
+    };
+    permuteArray(_x);
+    permuteArray(_y);
+    permuteArray(_z);
+    permuteArray(_vx);
+    permuteArray(_vy);
+    permuteArray(_vz);
+    permuteArray(_ax);
+    permuteArray(_ay);
+    permuteArray(_az);
+    permuteArray(_radius);
+    permuteArray(_fixed);
+    permuteArray(_toRemove);
+    permuteArray(_id);
+    permuteArray(_cost);
+    _fixedCurrent = false;
+    _regularizedFirst.clear();
+    _regularizedSecond.clear();
+
+    // Refitting would see most particles leave their leaf
+    _octree.build(_x.data(), _y.data(), _z.data(), _radius.data(), _radius.data(), n);
+    _treeCurrent = true;
+}
+
+/**
+ * @brief Spread the 21 low bits of a coordinate over every third bit, for a Morton code
+ * @param v The coordinate
+*/
+static uint64_t spreadBits(uint64_t v){
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+/**
+ * @brief Reorder the particles along a Morton curve through their bounding box, so that particles close in space
+ *        are close in the arrays. The black hole stays first
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::sortSpatially(){
+    size_t n = size();
+    if (n < 3){
+        return;
+    }
+
+    double lo[3] = {(double) _x[1], (double) _y[1], (double) _z[1]};
+    double hi[3] = {lo[0], lo[1], lo[2]};
+    for (size_t i = 2; i < n; i++){
+        lo[0] = std::min<double>(lo[0], _x[i]);
+        lo[1] = std::min<double>(lo[1], _y[i]);
+        lo[2] = std::min<double>(lo[2], _z[i]);
+        hi[0] = std::max<double>(hi[0], _x[i]);
+        hi[1] = std::max<double>(hi[1], _y[i]);
+        hi[2] = std::max<double>(hi[2], _z[i]);
+    }
+    double scale = 0x1fffff / std::max({hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2], 1e-30});
+
+    _sortKeys.resize(n - 1);
+    _sortOrder.resize(n);
+    _sortOrder[0] = 0;
+    forEachOwnedRange(n - 1, [&](size_t begin, size_t end){
+        for (size_t k = begin; k < end; k++){
+            size_t i = k + 1;
+            _sortKeys[k] = spreadBits((uint64_t) ((_x[i] - lo[0]) * scale))
+                         | spreadBits((uint64_t) ((_y[i] - lo[1]) * scale)) << 1
+                         | spreadBits((uint64_t) ((_z[i] - lo[2]) * scale)) << 2;
+            _sortOrder[i] = i;
+        }
+    });
+    _sorter.sort(_sortKeys.data(), _sortOrder.data() + 1, n - 1, 63);
+    permute(_sortOrder.data());
+}
+
+/**
+ * @brief Sort the particles spatially before the gravity, every k steps
+ * @param k Number of steps between two sorts, 0 to keep the order
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setSortPeriod(uint k){
+    _sortPeriod = k;
+}
+
+/**
+ * @brief Overwrite a particle of the set
+ * @param i Index of the particle
+ * @param x The x coordinate of the position
+ * @param y The y coordinate of the position
+ * @param z The z coordinate of the position
+ * @param radius Radius of the particle (in pixels), also used as its mass
+ * @param vx The x component of the velocity
+ * @param vy The y component of the velocity
+ * @param vz The z component of the velocity
+ * @param fixed Whether the particle is fixed or not
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setParticle(size_t i, T x, T y, T z, TOffset radius, TOffset vx, TOffset vy, TOffset vz, bool fixed){
+    // Only written when it changes, so that threads filling different particles share nothing
+    if (_treeCurrent){
+        _treeCurrent = false;
+    }
+    if (_fixedCurrent){
+        _fixedCurrent = false;
+    }
+    _x[i] = x;
+    _y[i] = y;
+    _z[i] = z;
+    _vx[i] = vx;
+    _vy[i] = vy;
+    _vz[i] = vz;
+    _ax[i] = 0;
+    _ay[i] = 0;
+    _az[i] = 0;
+    _radius[i] = radius;
+    _fixed[i] = fixed;
+    _toRemove[i] = false;
+}
+
+/**
+ * @brief Add a particle to the set
+ * @param point Conformal point (c3ga) giving the position of the particle
+ * @param radius Radius of the particle (in pixels), also used as its mass
+ * @param vx The x component of the velocity
+ * @param vy The y component of the velocity
+ * @param vz The z component of the velocity
+ * @param fixed Whether the particle is fixed or not
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::addParticle(const c3ga::Mvec<double>& point, TOffset radius, TOffset vx, TOffset vy, TOffset vz, bool fixed){
+    _treeCurrent = false;
+    _fixedCurrent = false;
+    _x.push_back(point[c3ga::E1]);
+    _y.push_back(point[c3ga::E2]);
+    _z.push_back(point[c3ga::E3]);
+    _vx.push_back(vx);
+    _vy.push_back(vy);
+    _vz.push_back(vz);
+    _ax.push_back(0);
+    _ay.push_back(0);
+    _az.push_back(0);
+    _radius.push_back(radius);
+    _fixed.push_back(fixed);
+    _toRemove.push_back(false);
+    _id.push_back(_nextId++);
+    _cost.push_back(0);
+}
+
+/**
+ * @brief Number of particles in the set
+*/
+template <typename T, typename TOffset>
+size_t ParticleSystem3D<T, TOffset>::size() const{
+    return _x.size();
+}
+
+template <typename T, typename TOffset>
+T ParticleSystem3D<T, TOffset>::getX(size_t i) const{
+    return _x[i];
+}
+
+template <typename T, typename TOffset>
+T ParticleSystem3D<T, TOffset>::getY(size_t i) const{
+    return _y[i];
+}
+
+template <typename T, typename TOffset>
+T ParticleSystem3D<T, TOffset>::getZ(size_t i) const{
+    return _z[i];
+}
+
+template <typename T, typename TOffset>
+TOffset ParticleSystem3D<T, TOffset>::getVX(size_t i) const{
+    return _vx[i];
+}
+
+template <typename T, typename TOffset>
+TOffset ParticleSystem3D<T, TOffset>::getVY(size_t i) const{
+    return _vy[i];
+}
+
+template <typename T, typename TOffset>
+TOffset ParticleSystem3D<T, TOffset>::getVZ(size_t i) const{
+    return _vz[i];
+}
+
+/**
+ * @brief Radius accessor
+*/
+template <typename T, typename TOffset>
+TOffset ParticleSystem3D<T, TOffset>::getRadius(size_t i) const{
+    return _radius[i];
+}
+
+/**
+ * @brief Identifier of a particle, it never changes and increases with the index
+ * @param i Index of the particle
+*/
+template <typename T, typename TOffset>
+uint64_t ParticleSystem3D<T, TOffset>::getId(size_t i) const{
+    return _id[i];
+}
+
+/**
+ * @brief Counters of rebuilds and refits of the octree
+*/
+template <typename T, typename TOffset>
+const OctreeStats& ParticleSystem3D<T, TOffset>::getTreeStats() const{
+    return _octree.stats();
+}
+
+/**
+ * @brief Change how the gravity is integrated
+ * @param parameters The softening, regularization and time step
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setGravity(const GravityParameters& parameters){
+    _gravity = parameters;
+    _softening = Softening<TOffset>(parameters.kernel, parameters.softening);
+}
+
+/**
+ * @brief How the gravity is integrated
+*/
+template <typename T, typename TOffset>
+const GravityParameters& ParticleSystem3D<T, TOffset>::getGravity() const{
+    return _gravity;
+}
+
+/**
+ * @brief Run the force loop and the kicks on a pool of workers, each one always handling the same range of
+ *        octree entries and of particles. The arrays allocated from now on are first written by the workers
+ *        owning their ranges, so that these ranges are on the NUMA node of their workers
+ * @param pool The workers, the calling thread doing everything if null. It must outlive the set
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setWorkerPool(WorkerPool* pool){
+    _pool = pool;
+    _octree.setWorkerPool(pool);
+    _sorter.setWorkerPool(pool);
+    if (_domains != nullptr){
+        _domains->setWorkerPool(pool);
+    }
+}
+
+/**
+ * @brief Share the force loop between the workers by cost instead of by number of particles: every k steps,
+ *        the octree entries are cut into ranges of the same number of interactions, as counted for each
+ *        particle during the previous step
+ * @param k Number of steps between two partitions, 0 for the fixed ranges owned by the workers
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::setBalancePeriod(uint k){
+    _balancePeriod = k;
+    _partition.clear();
+}
+
+/**
+ * @brief How evenly the workers shared the force loop
+*/
+template <typename T, typename TOffset>
+const BalanceStats& ParticleSystem3D<T, TOffset>::getBalanceStats() const{
+    return _balance;
+}
+
+/**
+ * @brief Number of pairs integrated as two-body orbits during the last step
+*/
+template <typename T, typename TOffset>
+size_t ParticleSystem3D<T, TOffset>::getRegularizedPairs() const{
+    return _regularizedFirst.size();
+}
+
+/**
+ * @brief Build the dual sphere (c3ga) of a particle: s = center - 0.5 radius^2 ei
+ * @param i Index of the particle
+*/
+template <typename T, typename TOffset>
+c3ga::Mvec<double> ParticleSystem3D<T, TOffset>::getDualSphere(size_t i) const{
+    // c3ga::dualSphere() subtracts 0.5 * radius, we need the squared radius so that s.s = radius^2
+    c3ga::Mvec<double> sphere = c3ga::point<double>(_x[i], _y[i], _z[i]);
+    sphere[c3ga::Ei] -= 0.5 * (double) _radius[i] * _radius[i];
+    return sphere;
+}
+
+/**
+ * @brief Check whether two particles are in contact, using the inner product of their dual spheres
+ * @param i Index of the first particle
+ * @param j Index of the second particle
+*/
+template <typename T, typename TOffset>
+bool ParticleSystem3D<T, TOffset>::isInContact(size_t i, size_t j) const{
+    // s_i.s_j = (r_i^2 + r_j^2 - d^2) / 2, so d <= r_i + r_j  <=>  s_i.s_j >= -r_i r_j
+    double inner = (getDualSphere(i) | getDualSphere(j))[c3ga::scalar];
+    return inner >= -(double) _radius[i] * _radius[j];
+}
+
+/**
+ * @brief Compute the acceleration of all particles with the Barnes-Hut octree and update their velocities
+ * @param diagnostics If not null, receives the conserved quantities before the step, the potential energy
+ *        coming from the same tree walk as the accelerations
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::applyGravity(ConservationSample* diagnostics){
+    if (_sortPeriod > 0 && _gravitySteps % _sortPeriod == 0){
+        sortSpatially();
+    }
+    _gravitySteps++;
+
+    TOffset* phi = nullptr;
+    if (diagnostics != nullptr){
+        _phi.resize(size());
+        phi = _phi.data();
+    }
+    bool distributed = _domains != nullptr && _domains->computeAccelerations(G, _softening, _x.data(), _y.data(), _z.data(), _radius.data(),
+                                                                             size(), _ax.data(), _ay.data(), _az.data(), phi);
+
+    // The regularization searches its pairs in the tree of this process
+    if (!distributed || _gravity.regularization > 0){
+        _octree.update(_x.data(), _y.data(), _z.data(), _radius.data(), _radius.data(), size());
+        _treeCurrent = true;
+    }
+    if (!distributed){
+        computeBalancedAccelerations(phi);
+    }
+    if (diagnostics != nullptr){
+        measureConservation(*diagnostics);
+    }
+
+    _regularizedFirst.clear();
+    _regularizedSecond.clear();
+    if (_gravity.regularization > 0){
+        findRegularizedPairs();
+    }
+
+    TOffset dt = _gravity.dt;
+    forEachOwnedRange(size(), [&](size_t begin, size_t end){
+        for (size_t i = begin; i < end; i++){
+            if (!_fixed[i]){
+                _vx[i] += _ax[i] * dt;
+                _vy[i] += _ay[i] * dt;
+                _vz[i] += _az[i] * dt;
+            }
+        }
+    });
+}
+
+/**
+ * @brief Sum the conserved quantities over the set, in parallel. The velocities are moved half a kick forward
+ *        so that they are at the same time as the positions
+ * @param sample Receives the sums
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::measureConservation(ConservationSample& sample){
+    // Kinetic, potential, momentum and angular momentum of each chunk, added in the order of the chunks
+    // so that the result does not depend on the number of workers
+    const int nb_sums = 8;
+    const size_t chunk_size = 1 << 14;
+    _partialSums.assign((size() + chunk_size - 1) / chunk_size * nb_sums, 0);
+    double half_dt = 0.5 * _gravity.dt;
+
+    auto sum_chunk = [&](size_t chunk, size_t begin, size_t end){
+        double sums[nb_sums] = {0, 0, 0, 0, 0, 0, 0, 0};
+        for (size_t i = begin; i < end; i++){
+            double m = _radius[i];
+            // Each pair is in the potential of both particles
+            sums[1] += 0.5 * m * _phi[i];
+            if (_fixed[i]){
+                continue;
+            }
+
+            // The kick of this step is not applied yet, the velocity is half a step behind the position
+            double v[3] = {_vx[i] + half_dt * _ax[i], _vy[i] + half_dt * _ay[i], _vz[i] + half_dt * _az[i]};
+            double r[3] = {(double) (_x[i] - _x[0]), (double) (_y[i] - _y[0]), (double) (_z[i] - _z[0])};
+            sums[0] += 0.5 * m * (v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            sums[2] += m * v[0];
+            sums[3] += m * v[1];
+            sums[4] += m * v[2];
+            sums[5] += m * (r[1] * v[2] - r[2] * v[1]);
+            sums[6] += m * (r[2] * v[0] - r[0] * v[2]);
+            sums[7] += m * (r[0] * v[1] - r[1] * v[0]);
+        }
+        std::copy(sums, sums + nb_sums, _partialSums.begin() + chunk * nb_sums);
+    };
+
+    // Each chunk is summed by the worker owning its first particle
+    forEachOwnedRange(size(), [&](size_t begin, size_t end){
+        for (size_t chunk = (begin + chunk_size - 1) / chunk_size; chunk * chunk_size < end; chunk++){
+            sum_chunk(chunk, chunk * chunk_size, std::min(size(), (chunk + 1) * chunk_size));
+        }
+    });
+
+    sample = ConservationSample();
+    sample.nbParticles = size();
+    for (size_t k = 0; k < _partialSums.size(); k += nb_sums){
+        sample.kinetic += _partialSums[k];
+        sample.potential += _partialSums[k + 1];
+        for (int a = 0; a < 3; a++){
+            sample.momentum[a] += _partialSums[k + 2 + a];
+            sample.angularMomentum[a] += _partialSums[k + 5 + a];
+        }
+    }
+}
+
+/**
+ * @brief Find the mutual nearest neighbours closer than the regularization radius,
+ *        and take their mutual force out of their accelerations
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::findRegularizedPairs(){
+    const uint32_t none = UINT32_MAX;
+    TOffset reach = _gravity.regularization;
+
+    _nearest.assign(size(), none);
+    for (size_t i = 0; i < size(); i++){
+        if (_fixed[i]){
+            continue;
+        }
+        TOffset nearest_d2 = reach * reach;
+        _octree.forEachCandidate(_x[i], _y[i], _z[i], reach, [&](uint32_t j){
+            if (j == i || _fixed[j]){
+                return;
+            }
+            TOffset dx = _x[j] - _x[i];
+            TOffset dy = _y[j] - _y[i];
+            TOffset dz = _z[j] - _z[i];
+            TOffset d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 < nearest_d2){
+                nearest_d2 = d2;
+                _nearest[i] = j;
+            }
+        });
+    }
+
+    for (size_t i = 0; i < size(); i++){
+        uint32_t j = _nearest[i];
+        if (j == none || j < i || _nearest[j] != i){
+            continue;
+        }
+        _regularizedFirst.push_back(i);
+        _regularizedSecond.push_back(j);
+
+        // The orbit of the pair replaces its mutual force, the rest of the set only moves its center of mass.
+        // The tree gave this force directly unless one of the particles was inside an approximated cell
+        TOffset dx = _x[j] - _x[i];
+        TOffset dy = _y[j] - _y[i];
+        TOffset dz = _z[j] - _z[i];
+        TOffset f = G * _softening.inverseCube(dx * dx + dy * dy + dz * dz);
+        _ax[i] -= f * _radius[j] * dx;
+        _ay[i] -= f * _radius[j] * dy;
+        _az[i] -= f * _radius[j] * dz;
+        _ax[j] += f * _radius[i] * dx;
+        _ay[j] += f * _radius[i] * dy;
+        _az[j] += f * _radius[i] * dz;
+    }
+}
+
+/**
+ * @brief Move all the non fixed particles according to their velocity
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::updateParticlesPosition(){
+    _treeCurrent = false;
+    _startCurrent = _gravity.sweptCollisions;
+    if (_startCurrent){
+        _startX = _x;
+        _startY = _y;
+        _startZ = _z;
+    }
+
+    bool pairs = !_regularizedFirst.empty();
+    if (pairs){
+        _regularized.assign(size(), false);
+        for (size_t k = 0; k < _regularizedFirst.size(); k++){
+            moveRegularizedPair(_regularizedFirst[k], _regularizedSecond[k]);
+            _regularized[_regularizedFirst[k]] = true;
+            _regularized[_regularizedSecond[k]] = true;
+        }
+    }
+
+    TOffset dt = _gravity.dt;
+    for (size_t i = 0; i < size(); i++){
+        if (!_fixed[i] && !(pairs && _regularized[i])){
+            _x[i] += _vx[i] * dt;
+            _y[i] += _vy[i] * dt;
+            _z[i] += _vz[i] * dt;
+        }
+    }
+}
+
+/**
+ * @brief Move a regularized pair over a step: its center of mass drifts, and the two particles follow their
+ *        two-body orbit around it with substeps short against the orbital time
+ * @param i Index of the first particle
+ * @param j Index of the second particle
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::moveRegularizedPair(size_t i, size_t j){
+    double mi = _radius[i];
+    double mj = _radius[j];
+    double total = mi + mj;
+    double gm = G * total;
+    double dt = _gravity.dt;
+    Softening<double> softening(_softening.kernel(), _softening.length());
+
+    // Relative motion, in double whatever the precision of the set
+    double r[3] = {(double) _x[j] - _x[i], (double) _y[j] - _y[i], (double) _z[j] - _z[i]};
+    double w[3] = {(double) _vx[j] - _vx[i], (double) _vy[j] - _vy[i], (double) _vz[j] - _vz[i]};
+    double center_v[3] = {(mi * _vx[i] + mj * _vx[j]) / total, (mi * _vy[i] + mj * _vy[j]) / total, (mi * _vz[i] + mj * _vz[j]) / total};
+
+    // Kick-drift-kick substeps, each a fixed fraction of the orbital time at the current separation
+    double t = 0;
+    for (uint s = 0; s < MAX_PAIR_SUBSTEPS && t < dt; s++){
+        double d2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        double h = dt - t;
+        if (s + 1 < MAX_PAIR_SUBSTEPS){
+            h = std::min(h, PAIR_ACCURACY * std::sqrt(d2 * std::sqrt(d2) / gm));
+        }
+
+        double f = gm * softening.inverseCube(d2);
+        for (int a = 0; a < 3; a++){
+            w[a] -= 0.5 * h * f * r[a];
+            r[a] += h * w[a];
+        }
+        d2 = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+        f = gm * softening.inverseCube(d2);
+        for (int a = 0; a < 3; a++){
+            w[a] -= 0.5 * h * f * r[a];
+        }
+        t += h;
+    }
+
+    // Both particles around the drifted center of mass
+    double center[3] = {(mi * _x[i] + mj * _x[j]) / total + center_v[0] * dt,
+                        (mi * _y[i] + mj * _y[j]) / total + center_v[1] * dt,
+                        (mi * _z[i] + mj * _z[j]) / total + center_v[2] * dt};
+    _x[i] = center[0] - mj / total * r[0];
+    _y[i] = center[1] - mj / total * r[1];
+    _z[i] = center[2] - mj / total * r[2];
+    _x[j] = center[0] + mi / total * r[0];
+    _y[j] = center[1] + mi / total * r[1];
+    _z[j] = center[2] + mi / total * r[2];
+    _vx[i] = center_v[0] - mj / total * w[0];
+    _vy[i] = center_v[1] - mj / total * w[1];
+    _vz[i] = center_v[2] - mj / total * w[2];
+    _vx[j] = center_v[0] + mi / total * w[0];
+    _vy[j] = center_v[1] + mi / total * w[1];
+    _vz[j] = center_v[2] + mi / total * w[2];
+}
+
+/**
+ * @brief Merge all the particles in contact, the octree provides the candidate pairs
+ *        and the dual spheres decide which of them are in contact, all at once.
+ *        The particles reaching a fixed body are first absorbed by it, the fixed bodies staying out of the pair search.
+ *        With swept collisions, the particles are spheres moving in straight lines over the last move, and the
+ *        pairs that touch at some time of the step merge in the order of their first contact
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::applyCollision(){
+    if (size() == 0){
+        return;
+    }
+
+    // A particle stays along its whole move in a sphere around the middle of the move, of radius _contactReach. The
+    // start positions are replaced by these middles, the tree of the pair search being built over them
+    bool swept = _startCurrent && _startX.size() == size();
+    _startCurrent = false;
+    const T* cx = _x.data();
+    const T* cy = _y.data();
+    const T* cz = _z.data();
+    _contactReach.resize(size());
+    if (swept){
+        for (size_t i = 0; i < size(); i++){
+            double dx = (double) _x[i] - _startX[i];
+            double dy = (double) _y[i] - _startY[i];
+            double dz = (double) _z[i] - _startZ[i];
+            _contactReach[i] = _radius[i] + 0.5 * std::sqrt(dx * dx + dy * dy + dz * dz);
+            _startX[i] = _x[i] - 0.5 * dx;
+            _startY[i] = _y[i] - 0.5 * dy;
+            _startZ[i] = _z[i] - 0.5 * dz;
+        }
+        cx = _startX.data();
+        cy = _startY.data();
+        cz = _startZ.data();
+    }
+    else {
+        for (size_t i = 0; i < size(); i++){
+            _contactReach[i] = _radius[i];
+        }
+    }
+
+    // The fixed bodies reach nothing, so that they do not grow the cells around them
+    findFixedBodies();
+    for (uint32_t f : _fixedBodies){
+        _contactReach[f] = 0;
+    }
+    _contactTree.update(cx, cy, cz, _radius.data(), _contactReach.data(), size());
+
+    applyAccretion(swept);
+
+    // Broad phase, between the particles that move and are still there
+    _pairFirst.clear();
+    _pairSecond.clear();
+    for (size_t i = 0; i < size(); i++){
+        if (_fixed[i] || _toRemove[i]){
+            continue;
+        }
+        _contactTree.forEachCandidate(cx[i], cy[i], cz[i], _contactReach[i], [&](uint32_t j){
+            if (j > i && !_fixed[j] && !_toRemove[j]){
+                _pairFirst.push_back(i);
+                _pairSecond.push_back(j);
+            }
+        });
+    }
+
+    // Narrow phase
+    if (swept){
+        findSweptContacts();
+    }
+    else {
+        // Spheres taken relative to the black hole, to keep the ei coefficients small in float
+        _spheres.resize(size());
+        _spheres.setOrigin(_x[0], _y[0], _z[0]);
+        for (size_t i = 0; i < size(); i++){
+            _spheres.setSphere(i, _x[i], _y[i], _z[i], _radius[i]);
+        }
+        _pairContact.resize(_pairFirst.size());
+        _spheres.testContacts(_pairFirst.data(), _pairSecond.data(), _pairFirst.size(), _pairContact.data());
+        _contacts.clear();
+        for (size_t k = 0; k < _pairContact.size(); k++){
+            if (_pairContact[k]){
+                _contacts.push_back(k);
+            }
+        }
+    }
+
+    for (uint32_t k : _contacts){
+        size_t i = _pairFirst[k];
+        size_t j = _pairSecond[k];
+        if (_toRemove[i] || _toRemove[j]){
+            continue;
+        }
+
+        // The biggest particle absorbs the other one
+        size_t keep = i;
+        size_t lost = j;
+        if (_radius[j] > _radius[i]){
+            std::swap(keep, lost);
+        }
+
+        TOffset total = _radius[keep] + _radius[lost];
+        _vx[keep] = (_vx[keep] * _radius[keep] + _vx[lost] * _radius[lost]) / total;
+        _vy[keep] = (_vy[keep] * _radius[keep] + _vy[lost] * _radius[lost]) / total;
+        _vz[keep] = (_vz[keep] * _radius[keep] + _vz[lost] * _radius[lost]) / total;
+
+        // Volume accurate grow
+        _radius[keep] = std::cbrt(std::pow(_radius[keep], 3) + std::pow(_radius[lost], 3));
+        _toRemove[lost] = true;
+        _treeCurrent = false;
+    }
+
+    removeMarkedParticles();
+}
+
+/**
+ * @brief List the fixed particles in _fixedBodies, if they may have changed since the last time
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::findFixedBodies(){
+    if (_fixedCurrent){
+        return;
+    }
+    _fixedBodies.clear();
+    for (size_t i = 0; i < size(); i++){
+        if (_fixed[i]){
+            _fixedBodies.push_back(i);
+        }
+    }
+    _fixedCurrent = true;
+}
+
+/**
+ * @brief Merge into the fixed bodies the particles that reach them, with a distance check of every particle
+ *        against every fixed body over the arrays
+ * @param swept Whether the particles are checked along their whole move, _startX holding the middles of the moves
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::applyAccretion(bool swept){
+    findFixedBodies();
+    size_t n = size();
+    _accretedBy.assign(n, 0);
+    if (_fixedBodies.empty()){
+        return;
+    }
+
+    // Branchless loops over the arrays, so that they are vectorized
+    const T* x = _x.data();
+    const T* y = _y.data();
+    const T* z = _z.data();
+    const T* mx = _startX.data();
+    const T* my = _startY.data();
+    const T* mz = _startZ.data();
+    const TOffset* radius = _radius.data();
+    uint32_t* accreted_by = _accretedBy.data();
+    for (uint32_t k = 0; k < _fixedBodies.size(); k++){
+        uint32_t f = _fixedBodies[k];
+        T fx = _x[f];
+        T fy = _y[f];
+        T fz = _z[f];
+        T fr = _radius[f];
+        if (swept){
+            // Closest point to the body of the move m + u h, u from -1 to 1, h being half of the move
+            for (size_t i = 0; i < n; i++){
+                T qx = mx[i] - fx;
+                T qy = my[i] - fy;
+                T qz = mz[i] - fz;
+                T hx = x[i] - mx[i];
+                T hy = y[i] - my[i];
+                T hz = z[i] - mz[i];
+                T hh = hx * hx + hy * hy + hz * hz;
+                // Clamped before the division, which keeps the loop free of branches
+                T uhh = -(qx * hx + qy * hy + qz * hz);
+                uhh = uhh > hh ? hh : uhh;
+                uhh = uhh < -hh ? -hh : uhh;
+                T u = uhh / (hh + std::numeric_limits<T>::min());
+                T dx = qx + u * hx;
+                T dy = qy + u * hy;
+                T dz = qz + u * hz;
+                T reach = fr + radius[i];
+                uint32_t hit = dx * dx + dy * dy + dz * dz <= reach * reach;
+                accreted_by[i] += (hit & (accreted_by[i] == 0)) * (k + 1);
+            }
+        }
+        else {
+            for (size_t i = 0; i < n; i++){
+                T dx = x[i] - fx;
+                T dy = y[i] - fy;
+                T dz = z[i] - fz;
+                T reach = fr + radius[i];
+                uint32_t hit = dx * dx + dy * dy + dz * dz <= reach * reach;
+                accreted_by[i] += (hit & (accreted_by[i] == 0)) * (k + 1);
+            }
+        }
+    }
+
+    // The bodies grow once every contact is known, like the pairs
+    for (size_t i = 0; i < n; i++){
+        if (_accretedBy[i] == 0 || _fixed[i]){
+            continue;
+        }
+        uint32_t f = _fixedBodies[_accretedBy[i] - 1];
+        _radius[f] = std::cbrt(std::pow(_radius[f], 3) + std::pow(_radius[i], 3));
+        _toRemove[i] = true;
+        _treeCurrent = false;
+    }
+}
+
+/**
+ * @brief Narrow phase of the swept collisions: find the candidate pairs whose spheres touch during the last move,
+ *        and sort them by time of first contact into _contacts
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::findSweptContacts(){
+    _contacts.clear();
+    _contactTimes.clear();
+    for (size_t k = 0; k < _pairFirst.size(); k++){
+        size_t i = _pairFirst[k];
+        size_t j = _pairSecond[k];
+
+        // Relative position s(t) = s + t d over the move, t from 0 to 1, touching when |s(t)| <= ri + rj.
+        // The start is twice the middle minus the end
+        double m[3] = {(double) _startX[j] - _startX[i], (double) _startY[j] - _startY[i], (double) _startZ[j] - _startZ[i]};
+        double e[3] = {(double) _x[j] - _x[i], (double) _y[j] - _y[i], (double) _z[j] - _z[i]};
+        double s[3] = {2 * m[0] - e[0], 2 * m[1] - e[1], 2 * m[2] - e[2]};
+        double d[3] = {e[0] - s[0], e[1] - s[1], e[2] - s[2]};
+        double reach = (double) _radius[i] + _radius[j];
+        double a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        double b = s[0] * d[0] + s[1] * d[1] + s[2] * d[2];
+        double c = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] - reach * reach;
+
+        float time;
+        if (c <= 0){
+            time = 0;
+        }
+        else if (b >= 0 || b * b < a * c){
+            continue;  // Moving apart, or passing by
+        }
+        else {
+            time = (-b - std::sqrt(b * b - a * c)) / a;
+            if (time > 1){
+                continue;
+            }
+        }
+
+        // Positive floats sort as their bits
+        uint32_t bits;
+        std::memcpy(&bits, &time, sizeof(bits));
+        _contacts.push_back(k);
+        _contactTimes.push_back(bits);
+    }
+    _sorter.sort(_contactTimes.data(), _contacts.data(), _contacts.size(), 32);
+}
+
+/**
+ * @brief Remove the particles marked in _toRemove, keeping the order of the others
+*/
+template <typename T, typename TOffset>
+void ParticleSystem3D<T, TOffset>::removeMarkedParticles(){
+    _octree.compact(_toRemove.data(), size());
+    _contactTree.compact(_toRemove.data(), size());
+    _fixedCurrent = false;
+    _regularizedFirst.clear();
+    _regularizedSecond.clear();
+
+    size_t kept = 0;
+    for (size_t i = 0; i < size(); i++){
+        if (_toRemove[i]){
+            continue;
+        }
+        _x[kept] = _x[i];
+        _y[kept] = _y[i];
+        _z[kept] = _z[i];
+        _vx[kept] = _vx[i];
+        _vy[kept] = _vy[i];
+        _vz[kept] = _vz[i];
+        _ax[kept] = _ax[i];
+        _ay[kept] = _ay[i];
+        _az[kept] = _az[i];
+        _radius[kept] = _radius[i];
+        _fixed[kept] = _fixed[i];
+        _toRemove[kept] = false;
+        _id[kept] = _id[i];
+        _cost[kept] = _cost[i];
+        kept++;
+    }
+
+    _x.resize(kept);
+    _y.resize(kept);
+    _z.resize(kept);
+    _vx.resize(kept);
+    _vy.resize(kept);
+    _vz.resize(kept);
+    _ax.resize(kept);
+    _ay.resize(kept);
+    _az.resize(kept);
+    _radius.resize(kept);
+    _fixed.resize(kept);
+    _toRemove.resize(kept);
+    _id.resize(kept);
+    _cost.resize(kept);
+}
+
+template class ParticleSystem3D<float>;
+template class ParticleSystem3D<double>;
+template class ParticleSystem3D<double, float>;
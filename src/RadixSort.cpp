@@ -0,0 +1,136 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <RadixSort.hpp>
+#include <algorithm>
+#include <cstring>
+
+template <typename K>
+const uint RadixSorter<K>::MAX_DIGIT_BITS = 11;
+
+template <typename K>
+const size_t RadixSorter<K>::MIN_PARALLEL_KEYS = 1 << 16;
+
+/**
+ * @brief Constructor
+ * @param pool The workers, the calling thread sorting alone if null
+*/
+template <typename K>
+RadixSorter<K>::RadixSorter(WorkerPool* pool)
+    : _pool {pool}
+    , _parallel {false}
+    {}
+
+/**
+ * @brief Sort key/index pairs by increasing key, pairs of equal keys keeping their order
+ * @param keys Array of keys, sorted in place
+ * @param indices Array of indices moved with their keys, ignored if null
+ * @param n The number of pairs
+ * @param keyBits Number of low bits that may be set in the keys, the other ones being ignored
+*/
+template <typename K>
+void RadixSorter<K>::sort(K* keys, uint32_t* indices, size_t n, uint keyBits){
+    keyBits = std::min<uint>(keyBits, 8 * sizeof(K));
+    uint passes = (keyBits + MAX_DIGIT_BITS - 1) / MAX_DIGIT_BITS;
+    if (n < 2 || passes == 0){
+        return;
+    }
+    _keys.resize(n);
+    if (indices != nullptr){
+        _indices.resize(n);
+    }
+
+    K* src_keys = keys;
+    K* dst_keys = _keys.data();
+    uint32_t* src_indices = indices;
+    uint32_t* dst_indices = indices != nullptr ? _indices.data() : nullptr;
+    _parallel = _pool != nullptr && n >= MIN_PARALLEL_KEYS;
+    uint workers = _parallel ? _pool->size() : 1;
+
+    uint shift = 0;
+    for (uint pass = 0; pass < passes; pass++){
+        // The bits left are spread evenly over the passes left
+        uint bits = (keyBits - shift + passes - pass - 1) / (passes - pass);
+        size_t buckets = (size_t) 1 << bits;
+        K mask = (K) (buckets - 1);
+
+        _counts.assign(workers * buckets, 0);
+        forEachRange(n, [&](uint worker, size_t begin, size_t end){
+            size_t* counts = _counts.data() + worker * buckets;
+            for (size_t k = begin; k < end; k++){
+                counts[(src_keys[k] >> shift) & mask]++;
+            }
+        });
+
+        // Digit by digit, then worker by worker, the counts become the positions of the first key of each one
+        size_t position = 0;
+        bool same_digit = false;
+        for (size_t digit = 0; digit < buckets && !same_digit; digit++){
+            size_t first = position;
+            for (uint worker = 0; worker < workers; worker++){
+                size_t count = _counts[worker * buckets + digit];
+                _counts[worker * buckets + digit] = position;
+                position += count;
+            }
+            same_digit = position - first == n;
+        }
+        if (same_digit){
+            shift += bits;
+            continue;
+        }
+
+        forEachRange(n, [&](uint worker, size_t begin, size_t end){
+            size_t* positions = _counts.data() + worker * buckets;
+            for (size_t k = begin; k < end; k++){
+                size_t to = positions[(src_keys[k] >> shift) & mask]++;
+                dst_keys[to] = src_keys[k];
+                if (dst_indices != nullptr){
+                    dst_indices[to] = src_indices[k];
+                }
+            }
+        });
+        std::swap(src_keys, dst_keys);
+        std::swap(src_indices, dst_indices);
+        shift += bits;
+    }
+
+    // After an odd number of passes, the pairs are in the buffers
+    if (src_keys != keys){
+        forEachRange(n, [&](uint, size_t begin, size_t end){
+            std::memcpy(keys + begin, src_keys + begin, (end - begin) * sizeof(K));
+            if (indices != nullptr){
+                std::memcpy(indices + begin, src_indices + begin, (end - begin) * sizeof(uint32_t));
+            }
+        });
+    }
+}
+
+/**
+ * @brief Sort on other workers
+ * @param pool The workers, the calling thread sorting alone if null
+*/
+template <typename K>
+void RadixSorter<K>::setWorkerPool(WorkerPool* pool){
+    _pool = pool;
+}
+
+/**
+ * @brief Call f(worker, begin, end) on the range of [0, n[ owned by each worker, or f(0, 0, n) if the current
+ *        sort runs on the calling thread
+ * @param n The number of items
+ * @param f The function called on each range
+*/
+template <typename K>
+template <typename F>
+void RadixSorter<K>::forEachRange(size_t n, F f){
+    if (!_parallel){
+        f(0, 0, n);
+        return;
+    }
+    _pool->forEachRange(n, f);
+}
+
+template class RadixSorter<uint32_t>;
+template class RadixSorter<uint64_t>;
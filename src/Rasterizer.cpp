@@ -0,0 +1,285 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <Rasterizer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+const int Rasterizer::TILE_SIZE = 64;  // A power of two, so that dividing a position by it is exact. Three color planes take 48 KB
+const float Rasterizer::GLOW_RADIUS = 2;
+const float Rasterizer::GLOW_STRENGTH = 0.35;
+const float Rasterizer::POINT_RADIUS = 0.5;
+const float Rasterizer::POINT_INTENSITY = 0.6;
+const size_t Rasterizer::BIN_CHUNK = 1 << 16;
+
+/**
+ * @brief Constructor
+ * @param width Width of the pixel buffer
+ * @param height Height of the pixel buffer
+ * @param nb_threads Number of threads drawing the tiles, 0 for one per hardware thread
+*/
+Rasterizer::Rasterizer(uint width, uint height, uint nb_threads)
+    : _width {width}
+    , _height {height}
+    , _nbThreads {nb_threads}
+    , _tilesX {(width + TILE_SIZE - 1) / TILE_SIZE}
+    , _tilesY {(height + TILE_SIZE - 1) / TILE_SIZE}
+    , _binStart (_tilesX * _tilesY + 1, 0)
+    , _pixels ((size_t) width * height, 0xFF000000u)
+    {}
+
+/**
+ * @brief Remove the discs added since the last render
+*/
+void Rasterizer::clear(){
+    _discs.clear();
+}
+
+/**
+ * @brief Call f(chunk, begin, end) on the chunks of [0, n[, the threads of the rasterizer taking the next chunk
+ *        when they are done
+ * @param n The number of items
+ * @param chunk_size The number of items of a chunk
+ * @param f The function called on each chunk
+*/
+template <typename F>
+void Rasterizer::forEachChunk(size_t n, size_t chunk_size, F f){
+    std::atomic<size_t> next_chunk {0};
+    size_t nb_chunks = (n + chunk_size - 1) / chunk_size;
+    auto run = [&](uint, size_t, size_t){
+        for (size_t chunk = next_chunk++; chunk < nb_chunks; chunk = next_chunk++){
+            f(chunk, chunk * chunk_size, std::min(n, (chunk + 1) * chunk_size));
+        }
+    };
+    if (nb_chunks <= 1){
+        run(0, 0, 0);
+        return;
+    }
+
+    if (_pool == nullptr){
+        _pool.reset(new WorkerPool(_nbThreads, false));
+        _poolBounds.resize(_pool->size() + 1);
+        for (size_t w = 0; w < _poolBounds.size(); w++){
+            _poolBounds[w] = w;
+        }
+    }
+    _pool->forEachPartition(_poolBounds, run);
+}
+
+/**
+ * @brief Radius beyond which a disc adds nothing
+ * @param radius The radius of the disc
+*/
+float Rasterizer::reach(float radius){
+    // Antialiasing takes half a pixel more than the glow
+    return radius < POINT_RADIUS ? 0 : radius * GLOW_RADIUS + 0.5f;
+}
+
+/**
+ * @brief Add a disc to the next render, ignored if its glow does not reach the buffer
+ * @param x The x coordinate of the center, in pixels
+ * @param y The y coordinate of the center, in pixels
+ * @param radius The radius of the disc, in pixels
+ * @param r Red component, 1 for full intensity
+ * @param g Green component, 1 for full intensity
+ * @param b Blue component, 1 for full intensity
+*/
+void Rasterizer::addDisc(float x, float y, float radius, float r, float g, float b){
+    float extent = reach(radius);
+    if (x + extent < 0 || y + extent < 0 || x - extent >= _width || y - extent >= _height){
+        return;
+    }
+    _discs.push_back(Disc{x, y, radius, r, g, b});
+}
+
+/**
+ * @brief Sort the discs into the bins of the tiles they touch
+*/
+void Rasterizer::binDiscs(){
+    size_t nb_tiles = (size_t) _tilesX * _tilesY;
+
+    // Tiles covered by the square around a disc, which reaches the buffer so that truncating is rounding down
+    auto for_each_tile = [&](const Disc& disc, auto f){
+        float extent = reach(disc.radius);
+        int tx0 = std::max(0.0f, disc.x - extent) / TILE_SIZE;
+        int ty0 = std::max(0.0f, disc.y - extent) / TILE_SIZE;
+        int tx1 = std::min<int>(_tilesX - 1, (disc.x + extent) / TILE_SIZE);
+        int ty1 = std::min<int>(_tilesY - 1, (disc.y + extent) / TILE_SIZE);
+        for (int ty = ty0; ty <= ty1; ty++){
+            for (int tx = tx0; tx <= tx1; tx++){
+                f((size_t) ty * _tilesX + tx);
+            }
+        }
+    };
+
+    // Each chunk of discs counts its discs per tile, then copies them after those of the previous tiles and chunks,
+    // so that the discs of a tile stay in the order they were added
+    size_t nb_chunks = (_discs.size() + BIN_CHUNK - 1) / BIN_CHUNK;
+    _chunkOffsets.assign(nb_chunks * nb_tiles, 0);
+    forEachChunk(_discs.size(), BIN_CHUNK, [&](size_t chunk, size_t begin, size_t end){
+        uint32_t* counts = &_chunkOffsets[chunk * nb_tiles];
+        for (size_t i = begin; i < end; i++){
+            for_each_tile(_discs[i], [&](size_t tile){ counts[tile]++; });
+        }
+    });
+    uint32_t total = 0;
+    for (size_t t = 0; t < nb_tiles; t++){
+        _binStart[t] = total;
+        for (size_t c = 0; c < nb_chunks; c++){
+            uint32_t count = _chunkOffsets[c * nb_tiles + t];
+            _chunkOffsets[c * nb_tiles + t] = total;
+            total += count;
+        }
+    }
+    _binStart[nb_tiles] = total;
+    _binDiscs.resize(total);
+    forEachChunk(_discs.size(), BIN_CHUNK, [&](size_t chunk, size_t begin, size_t end){
+        uint32_t* offsets = &_chunkOffsets[chunk * nb_tiles];
+        for (size_t i = begin; i < end; i++){
+            for_each_tile(_discs[i], [&](size_t tile){ _binDiscs[offsets[tile]++] = _discs[i]; });
+        }
+    });
+}
+
+/**
+ * @brief Draw the discs of a tile and write its pixels
+ * @param tile Index of the tile, row by row
+*/
+void Rasterizer::renderTile(size_t tile){
+    int tx0 = (tile % _tilesX) * TILE_SIZE;
+    int ty0 = (tile / _tilesX) * TILE_SIZE;
+    int tx1 = std::min<int>(tx0 + TILE_SIZE, _width);
+    int ty1 = std::min<int>(ty0 + TILE_SIZE, _height);
+
+    if (_binStart[tile] == _binStart[tile + 1]){
+        for (int py = ty0; py < ty1; py++){
+            std::fill(&_pixels[(size_t) py * _width + tx0], &_pixels[(size_t) py * _width + tx1], 0xFF000000u);
+        }
+        return;
+    }
+
+    float planes[3 * TILE_SIZE * TILE_SIZE];
+    float* red = planes;
+    float* green = planes + TILE_SIZE * TILE_SIZE;
+    float* blue = planes + 2 * TILE_SIZE * TILE_SIZE;
+    std::fill(planes, planes + 3 * TILE_SIZE * TILE_SIZE, 0.0f);
+
+    for (uint32_t k = _binStart[tile]; k < _binStart[tile + 1]; k++){
+        const Disc& disc = _binDiscs[k];
+        float cx = disc.x;
+        float cy = disc.y;
+        float cr = disc.r;
+        float cg = disc.g;
+        float cb = disc.b;
+
+        if (disc.radius < POINT_RADIUS){
+            // Added to the pixel under its center, which is in this tile
+            size_t pixel = (size_t) ((int) cy - ty0) * TILE_SIZE + ((int) cx - tx0);
+            red[pixel] += POINT_INTENSITY * cr;
+            green[pixel] += POINT_INTENSITY * cg;
+            blue[pixel] += POINT_INTENSITY * cb;
+            continue;
+        }
+
+        // Antialiased disc: full inside radius - 0.5, falling linearly in d^2 to 0 at radius + 0.5.
+        // Glow: GLOW_STRENGTH r^2 / d^2 outside the disc, shifted to reach 0 at the end of the disc's reach
+        float radius = disc.radius;
+        float r2 = radius * radius;
+        float outer2 = (radius + 0.5f) * (radius + 0.5f);
+        float inv_band = 1 / (2 * radius);
+        float extent = reach(radius);
+        float extent2 = extent * extent;
+        float glow_scale = GLOW_STRENGTH * r2;
+        float glow_end = glow_scale / extent2;
+
+        int py0 = std::max<float>(ty0, cy - extent);
+        int py1 = std::min<float>(ty1, cy + extent + 1);
+        for (int py = py0; py < py1; py++){
+            float dy = py + 0.5f - cy;
+            float dy2 = dy * dy;
+            if (dy2 >= extent2){
+                continue;
+            }
+            float half = std::sqrt(extent2 - dy2);
+            int px0 = std::max<float>(tx0, cx - half);
+            int px1 = std::min<float>(tx1, cx + half + 1);
+
+            size_t row = (size_t) (py - ty0) * TILE_SIZE;
+            float* row_red = red + row;
+            float* row_green = green + row;
+            float* row_blue = blue + row;
+            float x_offset = tx0 + 0.5f - cx;
+            // No branch in this loop, so that it is vectorized
+            for (int lx = px0 - tx0; lx < px1 - tx0; lx++){
+                float dx = lx + x_offset;
+                float d2 = dx * dx + dy2;
+                float disc = std::min(1.0f, std::max(0.0f, (outer2 - d2) * inv_band));
+                float glow = std::max(0.0f, glow_scale / std::max(d2, r2) - glow_end);
+                float c = disc + glow;
+                row_red[lx] += c * cr;
+                row_green[lx] += c * cg;
+                row_blue[lx] += c * cb;
+            }
+        }
+    }
+
+    for (int py = ty0; py < ty1; py++){
+        size_t row = (size_t) (py - ty0) * TILE_SIZE;
+        uint32_t* pixels = &_pixels[(size_t) py * _width + tx0];
+        for (int lx = 0; lx < tx1 - tx0; lx++){
+            uint32_t r = std::min(255.0f, red[row + lx] * 255);
+            uint32_t g = std::min(255.0f, green[row + lx] * 255);
+            uint32_t b = std::min(255.0f, blue[row + lx] * 255);
+            pixels[lx] = 0xFF000000u | r << 16 | g << 8 | b;
+        }
+    }
+}
+
+/**
+ * @brief Draw the discs added since the last clear() on a black background
+*/
+void Rasterizer::render(){
+    binDiscs();
+    forEachChunk((size_t) _tilesX * _tilesY, 1, [&](size_t tile, size_t, size_t){
+        renderTile(tile);
+    });
+}
+
+/**
+ * @brief Pixels drawn by the last render, in rows of width() ARGB values
+*/
+const uint32_t* Rasterizer::pixels() const{
+    return _pixels.data();
+}
+
+/**
+ * @brief Exchange the pixel buffer with another one, so that the last frame can be kept without copying it
+ * @param pixels A buffer of width() * height() pixels, whose content the next render overwrites entirely
+*/
+void Rasterizer::swapPixels(std::vector<uint32_t>& pixels){
+    _pixels.swap(pixels);
+}
+
+/**
+ * @brief Width of the pixel buffer
+*/
+uint Rasterizer::width() const{
+    return _width;
+}
+
+/**
+ * @brief Height of the pixel buffer
+*/
+uint Rasterizer::height() const{
+    return _height;
+}
+
+/**
+ * @brief Number of discs added since the last clear()
+*/
+size_t Rasterizer::discCount() const{
+    return _discs.size();
+}
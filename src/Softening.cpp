@@ -0,0 +1,48 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <Softening.hpp>
+
+template <typename T>
+const T Softening<T>::SPLINE_SUPPORT = 2.8;  // Same potential depth at the center as a Plummer sphere of the same eps
+
+/**
+ * @brief Constructor
+ * @param kernel Shape of the force at short distance
+ * @param length Softening length eps, the Plummer radius, or the spline length (whose support is 2.8 eps)
+*/
+template <typename T>
+Softening<T>::Softening(SofteningKernel kernel, T length)
+    : _kernel {kernel}
+    , _length {length}
+    , _eps2 {length * length}
+    , _h {SPLINE_SUPPORT * length}
+    , _invH {_h > 0 ? 1 / _h : 0}
+    , _invH3 {_invH * _invH * _invH}
+    {
+    // A null length is the Newtonian force whatever the kernel
+    if (length <= 0){
+        _kernel = SOFTENING_NONE;
+    }
+}
+
+/**
+ * @brief Shape of the force at short distance
+*/
+template <typename T>
+SofteningKernel Softening<T>::kernel() const{
+    return _kernel;
+}
+
+/**
+ * @brief Softening length eps
+*/
+template <typename T>
+T Softening<T>::length() const{
+    return _length;
+}
+
+template class Softening<float>;
+template class Softening<double>;
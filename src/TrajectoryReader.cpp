@@ -0,0 +1,251 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <TrajectoryReader.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Constructor, nothing is read until open() is called
+*/
+TrajectoryReader::TrajectoryReader()
+    : _fd {-1}
+    , _data {nullptr}
+    , _size {0}
+    , _header {}
+    , _current {-1}
+    {}
+
+/**
+ * @brief Destructor, unmaps the file
+*/
+TrajectoryReader::~TrajectoryReader(){
+    close();
+}
+
+/**
+ * @brief Map a trajectory file and load its index, rebuilt from the frames if the file was not closed
+ * @param path Path of the file
+ * @return false if the file cannot be read or is not a trajectory
+*/
+bool TrajectoryReader::open(const char* path){
+    close();
+
+    _fd = ::open(path, O_RDONLY);
+    struct stat status;
+    if (_fd < 0 || fstat(_fd, &status) != 0 || (size_t) status.st_size < sizeof(TrajectoryHeader)){
+        fprintf(stderr, "Could not read the trajectory file %s\n", path);
+        close();
+        return false;
+    }
+
+    _size = status.st_size;
+    void* data = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    if (data == MAP_FAILED){
+        fprintf(stderr, "Could not map the trajectory file %s\n", path);
+        close();
+        return false;
+    }
+    _data = (const uint8_t*) data;
+
+    std::memcpy(&_header, _data, sizeof(_header));
+    if (std::memcmp(_header.magic, TRAJECTORY_MAGIC, sizeof(_header.magic)) != 0 || _header.version != TRAJECTORY_VERSION){
+        fprintf(stderr, "%s is not a trajectory file\n", path);
+        close();
+        return false;
+    }
+
+    // Index written by the writer at close, otherwise found again from the frames
+    TrajectoryTrailer trailer;
+    bool has_index = false;
+    if (_size >= sizeof(TrajectoryHeader) + sizeof(trailer)){
+        std::memcpy(&trailer, _data + _size - sizeof(trailer), sizeof(trailer));
+        has_index = std::memcmp(trailer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(trailer.magic)) == 0
+                 && trailer.indexOffset + trailer.nbFrames * sizeof(TrajectoryIndexEntry) + sizeof(trailer) == _size;
+    }
+    if (has_index){
+        _index.resize(trailer.nbFrames);
+        std::memcpy(_index.data(), _data + trailer.indexOffset, trailer.nbFrames * sizeof(TrajectoryIndexEntry));
+    }
+    else {
+        rebuildIndex();
+    }
+
+    // Frames are read ahead while playing forward
+    madvise(data, _size, MADV_WILLNEED);
+    return true;
+}
+
+/**
+ * @brief Unmap the file
+*/
+void TrajectoryReader::close(){
+    if (_data != nullptr){
+        munmap((void*) _data, _size);
+        _data = nullptr;
+    }
+    if (_fd >= 0){
+        ::close(_fd);
+        _fd = -1;
+    }
+    _size = 0;
+    _index.clear();
+    _current = -1;
+}
+
+/**
+ * @brief Number of frames of the file
+*/
+size_t TrajectoryReader::frameCount() const{
+    return _index.size();
+}
+
+/**
+ * @brief Simulation step of a frame
+ * @param frame Index of the frame
+*/
+uint64_t TrajectoryReader::frameStep(size_t frame) const{
+    return _index[frame].step;
+}
+
+/**
+ * @brief Decode a frame into a set of particles, the black hole (identifier 0) being fixed
+ * @param frame Index of the frame
+ * @param particles Receives the particles of the frame
+ * @return false if the frame is out of range or corrupted
+*/
+template <typename T, typename TOffset>
+bool TrajectoryReader::readFrame(size_t frame, ParticleSystem3D<T, TOffset>& particles){
+    if (frame >= _index.size()){
+        return false;
+    }
+
+    if ((long) frame != _current){
+        // Start again from the keyframe of the chunk, unless the frame follows the last decoded one in the same chunk
+        size_t first = frame;
+        while (first > 0 && !(_index[first].flags & TRAJECTORY_KEYFRAME) && (long) first - 1 != _current){
+            first--;
+        }
+        for (size_t f = first; f <= frame; f++){
+            if (!decodeFrame(f)){
+                _current = -1;
+                return false;
+            }
+        }
+    }
+
+    size_t n = _ids.size();
+    bool velocities = _header.fieldMask & (1 << TRAJ_VX);
+    particles.resize(n);
+    for (size_t i = 0; i < n; i++){
+        particles.setParticle(i,
+                              _values[TRAJ_X][i] * _header.quantum[TRAJ_X],
+                              _values[TRAJ_Y][i] * _header.quantum[TRAJ_Y],
+                              _values[TRAJ_Z][i] * _header.quantum[TRAJ_Z],
+                              _values[TRAJ_RADIUS][i] * _header.quantum[TRAJ_RADIUS],
+                              velocities ? _values[TRAJ_VX][i] * _header.quantum[TRAJ_VX] : 0,
+                              velocities ? _values[TRAJ_VY][i] * _header.quantum[TRAJ_VY] : 0,
+                              velocities ? _values[TRAJ_VZ][i] * _header.quantum[TRAJ_VZ] : 0,
+                              _ids[i] == 0);
+    }
+    return true;
+}
+
+template bool TrajectoryReader::readFrame(size_t frame, ParticleSystem3D<float>& particles);
+template bool TrajectoryReader::readFrame(size_t frame, ParticleSystem3D<double>& particles);
+template bool TrajectoryReader::readFrame(size_t frame, ParticleSystem3D<double, float>& particles);
+
+/**
+ * @brief Decode the frame following the last decoded one (or the given keyframe)
+ * @param frame Index of the frame
+ * @return false if the frame is corrupted
+*/
+bool TrajectoryReader::decodeFrame(size_t frame){
+    const TrajectoryIndexEntry& entry = _index[frame];
+    TrajectoryFrameHeader header;
+    if (entry.offset + sizeof(header) > _size){
+        return false;
+    }
+    std::memcpy(&header, _data + entry.offset, sizeof(header));
+    if (header.magic != TRAJECTORY_FRAME_MAGIC || entry.offset + sizeof(header) + header.payloadSize > _size){
+        return false;
+    }
+
+    const uint8_t* data = _data + entry.offset + sizeof(header);
+    const uint8_t* end = data + header.payloadSize;
+    bool keyframe = header.flags & TRAJECTORY_KEYFRAME;
+    size_t n = header.nbParticles;
+
+    _nextIds.resize(n);
+    uint64_t id = 0;
+    for (size_t i = 0; i < n; i++){
+        uint64_t delta;
+        if (!readVarint(data, end, delta)){
+            return false;
+        }
+        id += delta;
+        _nextIds[i] = id;
+    }
+
+    for (int f = 0; f < TRAJ_FIELD_COUNT; f++){
+        _nextValues[f].resize(n);
+        if (!(_header.fieldMask & (1 << f))){
+            continue;
+        }
+
+        // Same particle in the previous frame, both frames being sorted by identifier
+        size_t p = 0;
+        for (size_t i = 0; i < n; i++){
+            uint64_t value;
+            if (!readVarint(data, end, value)){
+                return false;
+            }
+            int64_t reference = 0;
+            if (!keyframe){
+                while (p < _ids.size() && _ids[p] < _nextIds[i]){
+                    p++;
+                }
+                if (p < _ids.size() && _ids[p] == _nextIds[i]){
+                    reference = _values[f][p];
+                }
+            }
+            _nextValues[f][i] = zigzagDecode(value) + reference;
+        }
+    }
+
+    std::swap(_ids, _nextIds);
+    for (int f = 0; f < TRAJ_FIELD_COUNT; f++){
+        std::swap(_values[f], _nextValues[f]);
+    }
+    _current = frame;
+    return true;
+}
+
+/**
+ * @brief Rebuild the index by walking the frame headers, for files whose writer did not close them
+*/
+void TrajectoryReader::rebuildIndex(){
+    _index.clear();
+    size_t offset = sizeof(TrajectoryHeader);
+    TrajectoryFrameHeader header;
+    while (offset + sizeof(header) <= _size){
+        std::memcpy(&header, _data + offset, sizeof(header));
+        if (header.magic != TRAJECTORY_FRAME_MAGIC || offset + sizeof(header) + header.payloadSize > _size){
+            break;
+        }
+
+        TrajectoryIndexEntry entry;
+        entry.offset = offset;
+        entry.step = header.step;
+        entry.nbParticles = header.nbParticles;
+        entry.flags = header.flags;
+        _index.push_back(entry);
+        offset += sizeof(header) + header.payloadSize;
+    }
+}
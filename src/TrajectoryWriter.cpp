@@ -0,0 +1,282 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <TrajectoryWriter.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Constructor, nothing is written until open() is called
+*/
+TrajectoryWriter::TrajectoryWriter()
+    : _header {}
+    , _file {NULL}
+    , _stop {false}
+    , _queue {nullptr}
+    , _framesWritten {0}
+    , _framesDropped {0}
+    , _bytesWritten {0}
+    {}
+
+/**
+ * @brief Destructor, closes the file
+*/
+TrajectoryWriter::~TrajectoryWriter(){
+    close();
+}
+
+/**
+ * @brief Create the file and start the writer thread
+ * @param path Path of the file to write
+ * @param options What is recorded and how precisely
+ * @return false if the file could not be created
+*/
+bool TrajectoryWriter::open(const char* path, const TrajectoryOptions& options){
+    close();
+
+    _file = fopen(path, "wb");
+    if (_file == NULL){
+        fprintf(stderr, "Could not create the trajectory file %s\n", path);
+        return false;
+    }
+    setvbuf(_file, NULL, _IOFBF, 1 << 20);
+
+    _options = options;
+    _options.sampleEvery = std::max(1u, _options.sampleEvery);
+    _options.keyframeInterval = std::max(1u, _options.keyframeInterval);
+
+    std::memset(&_header, 0, sizeof(_header));
+    std::memcpy(_header.magic, TRAJECTORY_MAGIC, sizeof(_header.magic));
+    _header.version = TRAJECTORY_VERSION;
+    _header.fieldMask = (1 << TRAJ_X) | (1 << TRAJ_Y) | (1 << TRAJ_Z) | (1 << TRAJ_RADIUS);
+    if (_options.velocities){
+        _header.fieldMask |= (1 << TRAJ_VX) | (1 << TRAJ_VY) | (1 << TRAJ_VZ);
+    }
+    _header.quantum[TRAJ_X] = _options.positionQuantum;
+    _header.quantum[TRAJ_Y] = _options.positionQuantum;
+    _header.quantum[TRAJ_Z] = _options.positionQuantum;
+    _header.quantum[TRAJ_RADIUS] = _options.radiusQuantum;
+    _header.quantum[TRAJ_VX] = _options.velocityQuantum;
+    _header.quantum[TRAJ_VY] = _options.velocityQuantum;
+    _header.quantum[TRAJ_VZ] = _options.velocityQuantum;
+    _header.keyframeInterval = _options.keyframeInterval;
+    _header.sampleEvery = _options.sampleEvery;
+    fwrite(&_header, sizeof(_header), 1, _file);
+
+    _index.clear();
+    _previousIds.clear();
+    _framesWritten = 0;
+    _framesDropped = 0;
+    _bytesWritten = sizeof(_header);
+
+    _queue = new SpscQueue<TrajectorySnapshot>(_options.queueCapacity);
+    _stop = false;
+    _thread = std::thread(&TrajectoryWriter::writerLoop, this);
+    return true;
+}
+
+/**
+ * @brief Hand the state of a step to the writer thread, if the step is sampled. Never blocks
+ * @param particles The set of particles
+ * @param step Number of the simulation step
+ * @return false if the frame was dropped because the queue was full
+*/
+template <typename T, typename TOffset>
+bool TrajectoryWriter::record(const ParticleSystem3D<T, TOffset>& particles, uint64_t step){
+    if (_file == NULL || step % _options.sampleEvery != 0){
+        return true;
+    }
+
+    TrajectorySnapshot* snapshot = _queue->beginPush();
+    if (snapshot == nullptr){
+        _framesDropped++;
+        return false;
+    }
+
+    snapshot->step = step;
+    snapshot->ids.clear();
+    for (int f = 0; f < TRAJ_FIELD_COUNT; f++){
+        snapshot->fields[f].clear();
+    }
+
+    // Both the set and the selection are sorted by identifier
+    size_t selected = 0;
+    for (size_t i = 0; i < particles.size(); i++){
+        uint64_t id = particles.getId(i);
+        if (!_options.ids.empty()){
+            while (selected < _options.ids.size() && _options.ids[selected] < id){
+                selected++;
+            }
+            if (selected == _options.ids.size()){
+                break;
+            }
+            if (_options.ids[selected] != id){
+                continue;
+            }
+        }
+
+        snapshot->ids.push_back(id);
+        snapshot->fields[TRAJ_X].push_back(particles.getX(i));
+        snapshot->fields[TRAJ_Y].push_back(particles.getY(i));
+        snapshot->fields[TRAJ_Z].push_back(particles.getZ(i));
+        snapshot->fields[TRAJ_RADIUS].push_back(particles.getRadius(i));
+        if (_options.velocities){
+            snapshot->fields[TRAJ_VX].push_back(particles.getVX(i));
+            snapshot->fields[TRAJ_VY].push_back(particles.getVY(i));
+            snapshot->fields[TRAJ_VZ].push_back(particles.getVZ(i));
+        }
+    }
+
+    _queue->endPush();
+    return true;
+}
+
+template bool TrajectoryWriter::record(const ParticleSystem3D<float>& particles, uint64_t step);
+template bool TrajectoryWriter::record(const ParticleSystem3D<double>& particles, uint64_t step);
+template bool TrajectoryWriter::record(const ParticleSystem3D<double, float>& particles, uint64_t step);
+
+/**
+ * @brief Write the frames still queued and the index, then close the file
+*/
+void TrajectoryWriter::close(){
+    if (_file == NULL){
+        return;
+    }
+
+    _stop = true;
+    _thread.join();
+
+    TrajectoryTrailer trailer;
+    trailer.indexOffset = _bytesWritten;
+    trailer.nbFrames = _index.size();
+    std::memcpy(trailer.magic, TRAJECTORY_INDEX_MAGIC, sizeof(trailer.magic));
+    fwrite(_index.data(), sizeof(TrajectoryIndexEntry), _index.size(), _file);
+    fwrite(&trailer, sizeof(trailer), 1, _file);
+    _bytesWritten += _index.size() * sizeof(TrajectoryIndexEntry) + sizeof(trailer);
+
+    fclose(_file);
+    _file = NULL;
+    delete _queue;
+    _queue = nullptr;
+}
+
+/**
+ * @brief Whether a file is open
+*/
+bool TrajectoryWriter::isOpen() const{
+    return _file != NULL;
+}
+
+/**
+ * @brief Number of frames written so far
+*/
+uint64_t TrajectoryWriter::framesWritten() const{
+    return _framesWritten;
+}
+
+/**
+ * @brief Number of frames dropped because the queue was full
+*/
+uint64_t TrajectoryWriter::framesDropped() const{
+    return _framesDropped;
+}
+
+/**
+ * @brief Number of bytes written so far
+*/
+uint64_t TrajectoryWriter::bytesWritten() const{
+    return _bytesWritten;
+}
+
+/**
+ * @brief Loop of the writer thread: encode and write the queued frames until close() is called
+*/
+void TrajectoryWriter::writerLoop(){
+    while (true){
+        TrajectorySnapshot* snapshot = _queue->front();
+        if (snapshot != nullptr){
+            writeFrame(*snapshot);
+            _queue->pop();
+            continue;
+        }
+
+        // Nothing queued: leave once stopped, checking again for frames pushed just before the stop
+        if (_stop){
+            if (_queue->front() == nullptr){
+                break;
+            }
+            continue;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    fflush(_file);
+}
+
+/**
+ * @brief Encode a frame against the previous one and append it to the file
+ * @param snapshot The state to write
+*/
+void TrajectoryWriter::writeFrame(const TrajectorySnapshot& snapshot){
+    size_t n = snapshot.ids.size();
+    bool keyframe = _index.size() % _options.keyframeInterval == 0;
+
+    _payload.clear();
+
+    uint64_t previous_id = 0;
+    for (size_t i = 0; i < n; i++){
+        writeVarint(_payload, snapshot.ids[i] - previous_id);
+        previous_id = snapshot.ids[i];
+    }
+
+    for (int f = 0; f < TRAJ_FIELD_COUNT; f++){
+        if (!(_header.fieldMask & (1 << f))){
+            continue;
+        }
+
+        double inverse_quantum = 1 / _header.quantum[f];
+        _values[f].resize(n);
+        for (size_t i = 0; i < n; i++){
+            _values[f][i] = std::llround(snapshot.fields[f][i] * inverse_quantum);
+        }
+
+        // Same particle in the previous frame, both frames being sorted by identifier
+        size_t p = 0;
+        for (size_t i = 0; i < n; i++){
+            int64_t reference = 0;
+            if (!keyframe){
+                while (p < _previousIds.size() && _previousIds[p] < snapshot.ids[i]){
+                    p++;
+                }
+                if (p < _previousIds.size() && _previousIds[p] == snapshot.ids[i]){
+                    reference = _previousValues[f][p];
+                }
+            }
+            writeVarint(_payload, zigzagEncode(_values[f][i] - reference));
+        }
+        std::swap(_values[f], _previousValues[f]);
+    }
+    _previousIds = snapshot.ids;
+
+    TrajectoryFrameHeader frame;
+    frame.magic = TRAJECTORY_FRAME_MAGIC;
+    frame.flags = keyframe ? TRAJECTORY_KEYFRAME : 0;
+    frame.step = snapshot.step;
+    frame.nbParticles = n;
+    frame.payloadSize = _payload.size();
+
+    TrajectoryIndexEntry entry;
+    entry.offset = _bytesWritten;
+    entry.step = snapshot.step;
+    entry.nbParticles = n;
+    entry.flags = frame.flags;
+    _index.push_back(entry);
+
+    fwrite(&frame, sizeof(frame), 1, _file);
+    fwrite(_payload.data(), 1, _payload.size(), _file);
+    _bytesWritten += sizeof(frame) + _payload.size();
+    _framesWritten++;
+}
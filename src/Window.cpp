@@ -57,7 +57,15 @@ void Window::init(){
  * @brief Destroys the window and clean up all initialized SDL libraries
 */
 void Window::close_window(){
-    SDL_DestroyWindow( window );
+    if (density_texture != NULL){
+        SDL_DestroyTexture(density_texture);
+    }
+    if (frame_texture != NULL){
+        SDL_DestroyTexture(frame_texture);
+    }
+    if (window != NULL){
+        SDL_DestroyWindow( window );
+    }
     SDL_Quit();
 }
 
@@ -65,6 +73,9 @@ void Window::close_window(){
  * @brief Update the screen with all the rendering
 */
 void Window::update_window(){
+    if (gRenderer == NULL){
+        return;
+    }
     SDL_SetRenderDrawColor( gRenderer, 0, 0xFF, 0xFF, 0xFF );
     SDL_UpdateWindowSurface( window );
     SDL_RenderPresent( gRenderer );
@@ -74,6 +85,9 @@ void Window::update_window(){
  * @brief Clears the window of all rendered targets
 */
 void Window::clear_window(){
+    if (gRenderer == NULL){
+        return;
+    }
     // TODO : Code color management better ...
     SDL_SetRenderDrawColor( gRenderer, 0, 0, 0, 0xFF ); // Set color to black when clearing window
     SDL_RenderClear(gRenderer);
@@ -84,13 +98,30 @@ void Window::clear_window(){
  * @brief The class constructor
  * @param width Width of the window
  * @param height Height of the window
+ * @param headless Draw offscreen only, without initiating SDL: the particles are drawn by the software
+ *        rasterizer and only reach the exporter
 */
-Window::Window(uint width, uint height)
-    : w_width {width}
+Window::Window(uint width, uint height, bool headless)
+    : window {NULL}
+    , w_surface {NULL}
+    , gRenderer {NULL}
+    , w_width {width}
     , w_height {height}
-    , current_pos {Vector<int>{0, 0}}
+    , current_pos {Vector<float>{0, 0}}
+    , zoom {1}
+    , density_texture {NULL}
+    , density (width * height, 0)
+    , density_pixels (width * height, 0)
+    , density_top {(int) height}
+    , density_bottom {-1}
+    , software_rendering {headless}
+    , rasterizer {width, height}
+    , frame_texture {NULL}
+    , exporter {nullptr}
     {
-        init();
+        if (!headless){
+            init();
+        }
     }
 
 /**
@@ -100,22 +131,41 @@ Window::Window(uint width, uint height)
  * @param radius the radius of the circle (in pixels)
 */
 void Window::draw_circle(int x0, int y0, uint radius){
+    circle_buffer.clear();
+    circle_points(x0, y0, radius, circle_buffer);
+    SDL_RenderDrawPoints(gRenderer, circle_buffer.data(), circle_buffer.size());
+}
+
+/**
+ * @brief Append the points of a circle that fall inside the window (Midpoint circle algorithm)
+ * @param x0 the x coordinate of the center of the circle
+ * @param y0 the y coordinate of the center of the circle
+ * @param radius the radius of the circle (in pixels)
+ * @param points Receives the points
+*/
+void Window::circle_points(int x0, int y0, uint radius, std::vector<SDL_Point>& points) const{
     int x = radius - 1;
     int y = 0;
     int dx = 1;
     int dy = 1;
     int err = dx - (radius << 1);
 
+    auto add = [&](int px, int py){
+        if (px >= 0 && py >= 0 && px < (int) w_width && py < (int) w_height){
+            points.push_back(SDL_Point{px, py});
+        }
+    };
+
     while (x >= y)
     {
-        SDL_RenderDrawPoint(gRenderer ,x0 + x, y0 + y);
-        SDL_RenderDrawPoint(gRenderer ,x0 + y, y0 + x);
-        SDL_RenderDrawPoint(gRenderer ,x0 - y, y0 + x);
-        SDL_RenderDrawPoint(gRenderer ,x0 - x, y0 + y);
-        SDL_RenderDrawPoint(gRenderer ,x0 - x, y0 - y);
-        SDL_RenderDrawPoint(gRenderer ,x0 - y, y0 - x);
-        SDL_RenderDrawPoint(gRenderer ,x0 + y, y0 - x);
-        SDL_RenderDrawPoint(gRenderer ,x0 + x, y0 - y);
+        add(x0 + x, y0 + y);
+        add(x0 + y, y0 + x);
+        add(x0 - y, y0 + x);
+        add(x0 - x, y0 + y);
+        add(x0 - x, y0 - y);
+        add(x0 - y, y0 - x);
+        add(x0 + y, y0 - x);
+        add(x0 + x, y0 - y);
 
         if (err <= 0)
         {
@@ -134,30 +184,207 @@ void Window::draw_circle(int x0, int y0, uint radius){
 }
 
 /**
- * @brief Draw a particle
+ * @brief Draw a particle, or add it to the density texture if it is smaller than a pixel
  * @param particle The particle to be drawn
 */
 void Window::draw_particle(Particle particle){
     Vector pos = particle.getPosition();
-    uint radius = particle.getRadius();
-    draw_circle(pos.x + current_pos.x, pos.y + current_pos.y, radius);
+    float x = pos.x * zoom + current_pos.x;
+    float y = pos.y * zoom + current_pos.y;
+    float radius = particle.getRadius() * zoom;
+    if (radius < 1){
+        splat_point(x, y);
+        return;
+    }
+    draw_circle(x, y, radius);
 }
 
 /**
- * @brief Draw all the particles in the vector
+ * @brief Draw all the particles in the vector, the ones smaller than a pixel going to the density texture
+ *        drawn once at the end
  * @param particles A vector of particles
 */
 void Window::draw_particles(std::vector<Particle>& particles){
     for (Particle& p : particles){
-        set_rendering_color(0, 0, 255, 255);
+        Vector<float> pos = p.getPosition();
+        float x = pos.x * zoom + current_pos.x;
+        float y = pos.y * zoom + current_pos.y;
+        if (!is_visible(x, y, p.getRadius() * zoom)){
+            continue;
+        }
+        uint red = 0;
 
         for (Particle& other : particles){
             if (&p != &other && p.isInContact(other)){
-                set_rendering_color(255, 0, 255, 255);  // Draw particle in pink if they are in contact
+                red = 255;  // Draw particle in pink if they are in contact
             }
         }
+        if (software_rendering){
+            rasterizer.addDisc(x, y, p.getRadius() * zoom, red / 255.0f, 0, 1);
+            continue;
+        }
+        set_rendering_color(red, 0, 255, 255);
         draw_particle(p);
     }
+    if (software_rendering){
+        draw_software_frame();
+        return;
+    }
+    draw_density();
+}
+
+/**
+ * @brief Draw all the particles of a 3D set, using an orthographic projection along the z axis.
+ *        Only the particles found by the octree under the window are drawn: they are first all moved to screen
+ *        coordinates, then their circles are drawn in one batch of points per shade. The ones smaller than a pixel
+ *        are added to a density texture drawn once at the end, brighter where more of them fall on the same pixel.
+ *        With software rendering, the visible particles are given to the rasterizer instead
+ * @param particles A 3D set of particles
+*/
+template <typename T, typename TOffset>
+void Window::draw_particles(ParticleSystem3D<T, TOffset>& particles){
+    const int nb_shades = sizeof(shade_points) / sizeof(shade_points[0]);
+
+    // World rectangle seen through the window
+    T xmin = -current_pos.x / zoom;
+    T ymin = -current_pos.y / zoom;
+    T xmax = (w_width - current_pos.x) / zoom;
+    T ymax = (w_height - current_pos.y) / zoom;
+    visible.clear();
+    particles.forEachInColumn(xmin, xmax, ymin, ymax, [&](uint32_t i){
+        visible.push_back(i);
+    });
+
+    // World to screen
+    size_t n = visible.size();
+    screen_x.resize(n);
+    screen_y.resize(n);
+    screen_radius.resize(n);
+    screen_shade.resize(n);
+    float depth = std::min(w_width, w_height);
+    for (size_t k = 0; k < n; k++){
+        uint32_t i = visible[k];
+        screen_x[k] = particles.getX(i) * zoom + current_pos.x;
+        screen_y[k] = particles.getY(i) * zoom + current_pos.y;
+        screen_radius[k] = particles.getRadius(i) * zoom;
+        // The closer to the viewer (high z), the brighter
+        float shade = std::max(-1.0f, std::min(1.0f, (float) (particles.getZ(i) / depth)));
+        screen_shade[k] = std::min(nb_shades - 1, (int) ((shade + 1) / 2 * nb_shades));
+    }
+
+    for (size_t k = 0; k < n; k++){
+        if (!is_visible(screen_x[k], screen_y[k], screen_radius[k])){
+            continue;
+        }
+        if (software_rendering){
+            float blue = (65 + 190 * (screen_shade[k] + 0.5f) / nb_shades) / 255;
+            rasterizer.addDisc(screen_x[k], screen_y[k], screen_radius[k], 0, 0, blue);
+            continue;
+        }
+        if (screen_radius[k] < 1){
+            splat_point(screen_x[k], screen_y[k]);
+            continue;
+        }
+        circle_points(screen_x[k], screen_y[k], screen_radius[k], shade_points[screen_shade[k]]);
+    }
+    if (software_rendering){
+        draw_software_frame();
+        return;
+    }
+
+    for (int s = 0; s < nb_shades; s++){
+        if (shade_points[s].empty()){
+            continue;
+        }
+        set_rendering_color(0, 0, 65 + 190 * (s + 0.5f) / nb_shades, 255);
+        SDL_RenderDrawPoints(gRenderer, shade_points[s].data(), shade_points[s].size());
+        shade_points[s].clear();
+    }
+    draw_density();
+}
+
+template void Window::draw_particles(ParticleSystem3D<float>& particles);
+template void Window::draw_particles(ParticleSystem3D<double>& particles);
+template void Window::draw_particles(ParticleSystem3D<double, float>& particles);
+
+/**
+ * @brief Draw the duration of the phases of the last frames as stacked bars in the bottom left corner,
+ *        and show their averages in the title of the window
+ * @param profiler The profiler recording the frames
+ * @param physics Profiler of the physics thread, drawn to the right of the first one, ignored if null
+*/
+void Window::draw_profiler(const FrameProfiler& profiler, const FrameProfiler* physics){
+    const uint bar_width = 2;
+    const float pixels_per_ms = 6;
+    uint64_t nb_frames = std::min<uint64_t>(w_width / 3 / bar_width, profiler.capacity());
+
+    draw_profiler_bars(profiler, 0, bar_width, pixels_per_ms);
+    if (physics != nullptr){
+        draw_profiler_bars(*physics, nb_frames * bar_width + 8, bar_width, pixels_per_ms);
+    }
+
+    // 60 fps budget
+    set_rendering_color(255, 255, 255, 255);
+    int budget_y = w_height - 16.6f * pixels_per_ms;
+    SDL_RenderDrawLine(gRenderer, 0, budget_y, (physics != nullptr ? 2 * nb_frames * bar_width + 8 : nb_frames * bar_width), budget_y);
+    set_rendering_color(0, 255, 255, 255);
+
+    // No text rendering available, the averages go to the title, refreshed twice per second
+    if (profiler.frameCount() % 30 == 0){
+        char title[512];
+        int length = snprintf(title, sizeof(title), "GravitySim");
+        const FrameProfiler* profilers[2] = {&profiler, physics};
+        for (int k = 0; k < 2 && profilers[k] != nullptr; k++){
+            if (k == 1){
+                length += snprintf(title + length, sizeof(title) - length, " || physics");
+            }
+            for (int p = 0; p < PHASE_COUNT && length < (int) sizeof(title); p++){
+                double average = profilers[k]->averagePhaseDuration((FramePhase) p, 30);
+                if (average > 0){
+                    length += snprintf(title + length, sizeof(title) - length, " | %s %.2f ms", FrameProfiler::phaseName((FramePhase) p), average);
+                }
+            }
+        }
+        SDL_SetWindowTitle(window, title);
+    }
+}
+
+/**
+ * @brief Draw the duration of the phases of the last frames of a profiler as stacked bars, starting from the bottom
+ * @param profiler The profiler recording the frames
+ * @param left The x coordinate of the first bar
+ * @param bar_width The width of a bar
+ * @param pixels_per_ms The height of one millisecond
+*/
+void Window::draw_profiler_bars(const FrameProfiler& profiler, uint left, uint bar_width, float pixels_per_ms){
+    const uint8_t colors[PHASE_COUNT][3] = {{230, 80, 60},    // Gravity
+                                            {80, 200, 80},    // Draw
+                                            {80, 120, 230},   // Present
+                                            {230, 200, 60},   // Move
+                                            {200, 80, 200},   // Collision
+                                            {80, 220, 220},   // Snapshot
+                                            {90, 90, 90}};    // Sleep
+
+    uint64_t published = profiler.frameCount();
+    uint64_t nb_frames = std::min<uint64_t>(w_width / 3 / bar_width, profiler.capacity());
+    uint64_t first = published > nb_frames ? published - nb_frames : 0;
+
+    FrameRecord frame;
+    for (uint64_t i = first; i < published; i++){
+        if (!profiler.getFrame(i, frame)){
+            continue;
+        }
+        SDL_Rect bar;
+        bar.x = left + (i - first) * bar_width;
+        bar.y = w_height;
+        bar.w = bar_width;
+        for (int p = 0; p < PHASE_COUNT; p++){
+            bar.h = (frame.phaseEnd[p] - frame.phaseBegin[p]) / 1e6 * pixels_per_ms;
+            bar.y -= bar.h;
+            set_rendering_color(colors[p][0], colors[p][1], colors[p][2], 255);
+            SDL_RenderFillRect(gRenderer, &bar);
+        }
+    }
 }
 
 /**
@@ -171,6 +398,120 @@ void Window::set_rendering_color(uint r, uint g, uint b, uint a){
     SDL_SetRenderDrawColor( gRenderer, r, g, b, a );
 }
 
+/**
+ * @brief Multiply the zoom by a factor, the world point under (x, y) staying in place
+ * @param factor The factor applied to the zoom, above 1 to zoom in
+ * @param x The x coordinate of the fixed point, in window pixels
+ * @param y The y coordinate of the fixed point, in window pixels
+*/
+void Window::zoom_window(float factor, int x, int y){
+    float world_x = (x - current_pos.x) / zoom;
+    float world_y = (y - current_pos.y) / zoom;
+    zoom = std::max(1e-4f, std::min(1e4f, zoom * factor));
+    current_pos.x = x - world_x * zoom;
+    current_pos.y = y - world_y * zoom;
+}
+
+/**
+ * @brief Whether a circle can be seen in the window
+ * @param x The x coordinate of the center of the circle, in window pixels
+ * @param y The y coordinate of the center of the circle, in window pixels
+ * @param radius The radius of the circle (in pixels)
+*/
+bool Window::is_visible(float x, float y, float radius) const{
+    return x + radius >= 0 && x - radius < w_width && y + radius >= 0 && y - radius < w_height;
+}
+
+/**
+ * @brief Add a particle smaller than a pixel to the density texture
+ * @param x The x coordinate of the particle, in window pixels
+ * @param y The y coordinate of the particle, in window pixels
+*/
+void Window::splat_point(float x, float y){
+    if (x < 0 || y < 0 || x >= w_width || y >= w_height){
+        return;
+    }
+    int px = x;
+    int py = y;
+    uint16_t& count = density[py * w_width + px];
+    if (count < UINT16_MAX){
+        count++;
+    }
+    density_top = std::min(density_top, py);
+    density_bottom = std::max(density_bottom, py);
+}
+
+/**
+ * @brief Upload the rows of the density texture touched since the last call, draw them and clear them
+*/
+void Window::draw_density(){
+    if (density_top > density_bottom){
+        return;
+    }
+    if (density_texture == NULL){
+        density_texture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w_width, w_height);
+        SDL_SetTextureBlendMode(density_texture, SDL_BLENDMODE_BLEND);
+    }
+
+    // Same blue as the circles, saturating after 8 particles on a pixel. Empty pixels are transparent
+    size_t begin = (size_t) density_top * w_width;
+    size_t end = (size_t) (density_bottom + 1) * w_width;
+    for (size_t k = begin; k < end; k++){
+        uint32_t count = density[k];
+        density_pixels[k] = count == 0 ? 0 : 0xFF000000u | std::min<uint32_t>(255, 128 + 16 * count);
+        density[k] = 0;
+    }
+
+    SDL_Rect rows = {0, density_top, (int) w_width, density_bottom - density_top + 1};
+    SDL_UpdateTexture(density_texture, &rows, density_pixels.data() + begin, w_width * sizeof(uint32_t));
+    SDL_RenderCopy(gRenderer, density_texture, &rows, &rows);
+
+    density_top = w_height;
+    density_bottom = -1;
+}
+
+/**
+ * @brief Render the discs given to the software rasterizer, upload them and draw them over the whole window
+*/
+void Window::draw_software_frame(){
+    rasterizer.render();
+    if (gRenderer != NULL){
+        if (frame_texture == NULL){
+            frame_texture = SDL_CreateTexture(gRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w_width, w_height);
+        }
+        SDL_UpdateTexture(frame_texture, NULL, rasterizer.pixels(), w_width * sizeof(uint32_t));
+        SDL_RenderCopy(gRenderer, frame_texture, NULL, NULL);
+    }
+    if (exporter != nullptr){
+        exporter->record(rasterizer);
+    }
+    rasterizer.clear();
+}
+
+/**
+ * @brief Choose how the particles are drawn: filled discs drawn by the software rasterizer and uploaded as one
+ *        texture per frame, or circles drawn by the SDL renderer
+ * @param enabled Whether the software rasterizer is used
+*/
+void Window::set_software_rendering(bool enabled){
+    software_rendering = enabled || gRenderer == NULL;
+}
+
+/**
+ * @brief Whether the particles are drawn by the software rasterizer
+*/
+bool Window::is_software_rendering() const{
+    return software_rendering;
+}
+
+/**
+ * @brief Hand the frames drawn by the software rasterizer to an exporter, after drawing them on the window
+ * @param frame_exporter The exporter, none if null
+*/
+void Window::set_exporter(FrameExporter* frame_exporter){
+    exporter = frame_exporter;
+}
+
 /**
  * @brief Move the point of focus of the window by adding x and y to the current position
  * @param x The number of pixel to move horizontally from
@@ -0,0 +1,208 @@
+/*
+Author: Kevin QUACH
+Created: 19/10/2026
+*/
+
+#include <WorkerPool.hpp>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+
+const size_t WorkerPool::RANGE_ALIGN = 1024;
+
+/**
+ * @brief Constructor, starts the workers
+ * @param nb_workers Number of workers, 0 for one per CPU the process may run on
+ * @param pin Whether each worker is bound to one CPU
+*/
+WorkerPool::WorkerPool(uint nb_workers, bool pin)
+    : _topology {NumaTopology::detect()}
+    , _task {nullptr}
+    , _taskSize {0}
+    , _taskBounds {nullptr}
+    , _generation {0}
+    , _pending {0}
+    , _stop {false}
+    {
+    std::vector<const NumaNode*> nodes;
+    for (const NumaNode& node : _topology.nodes()){
+        if (!node.cpus.empty()){
+            nodes.push_back(&node);
+        }
+    }
+    nb_workers = nb_workers != 0 ? nb_workers : std::max<uint>(1, _topology.cpuCount());
+
+    // Worker w goes to node w * nodes / workers, so that the ranges of a node are contiguous
+    std::vector<size_t> used(nodes.size(), 0);
+    for (uint w = 0; w < nb_workers; w++){
+        size_t k = (size_t) w * nodes.size() / nb_workers;
+        const NumaNode& node = *nodes[k];
+        _cpus.push_back(pin ? node.cpus[used[k]++ % node.cpus.size()] : -1);
+        _nodes.push_back(node.id);
+    }
+
+    for (uint w = 0; w < nb_workers; w++){
+        _threads.emplace_back(&WorkerPool::workerLoop, this, w);
+    }
+}
+
+/**
+ * @brief Destructor, stops the workers
+*/
+WorkerPool::~WorkerPool(){
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _taskReady.notify_all();
+    for (std::thread& thread : _threads){
+        thread.join();
+    }
+}
+
+/**
+ * @brief Call f(worker, begin, end) on the range of [0, n[ owned by each worker, in parallel, and wait for them.
+ *        Calls from several threads run one after the other
+ * @param n The number of items
+ * @param f The function called by each worker on its range, skipped for empty ranges
+*/
+void WorkerPool::forEachRange(size_t n, const std::function<void(uint, size_t, size_t)>& f){
+    std::lock_guard<std::mutex> call(_callMutex);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _task = &f;
+    _taskSize = n;
+    _taskBounds = nullptr;
+    _pending = size();
+    _generation++;
+    _taskReady.notify_all();
+    _taskDone.wait(lock, [this](){
+        return _pending == 0;
+    });
+    _task = nullptr;
+}
+
+/**
+ * @brief Call f(worker, begin, end) on ranges chosen by the caller, worker w getting [bounds[w], bounds[w + 1][,
+ *        in parallel, and wait for them
+ * @param bounds The size() + 1 bounds of the ranges, in increasing order
+ * @param f The function called by each worker on its range, skipped for empty ranges
+*/
+void WorkerPool::forEachPartition(const std::vector<size_t>& bounds, const std::function<void(uint, size_t, size_t)>& f){
+    std::lock_guard<std::mutex> call(_callMutex);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _task = &f;
+    _taskSize = bounds.back();
+    _taskBounds = bounds.data();
+    _pending = size();
+    _generation++;
+    _taskReady.notify_all();
+    _taskDone.wait(lock, [this](){
+        return _pending == 0;
+    });
+    _task = nullptr;
+    _taskBounds = nullptr;
+}
+
+/**
+ * @brief First item of the range owned by a worker
+ * @param n The number of items
+ * @param worker The worker, size() for the end of the last range
+*/
+size_t WorkerPool::rangeBegin(size_t n, uint worker) const{
+    if (worker >= size()){
+        return n;
+    }
+    size_t begin = n / size() * worker + n % size() * worker / size();
+    return std::min(n, begin / RANGE_ALIGN * RANGE_ALIGN);
+}
+
+/**
+ * @brief Number of workers
+*/
+uint WorkerPool::size() const{
+    return _cpus.size();
+}
+
+/**
+ * @brief CPU a worker is pinned to, -1 if it is not
+ * @param worker The worker
+*/
+int WorkerPool::cpu(uint worker) const{
+    return _cpus[worker];
+}
+
+/**
+ * @brief NUMA node of a worker
+ * @param worker The worker
+*/
+int WorkerPool::node(uint worker) const{
+    return _nodes[worker];
+}
+
+/**
+ * @brief Topology the workers were spread over
+*/
+const NumaTopology& WorkerPool::topology() const{
+    return _topology;
+}
+
+/**
+ * @brief Write the topology and where the workers run
+ * @param out The stream written to
+*/
+void WorkerPool::print(FILE* out) const{
+    _topology.print(out);
+    fprintf(out, "Workers: %u", size());
+    if (_cpus[0] >= 0){
+        std::vector<int> cpus = _cpus;
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        fprintf(out, ", pinned to CPUs ");
+        NumaTopology::printCpus(out, cpus);
+    }
+    else {
+        fprintf(out, ", not pinned");
+    }
+    fprintf(out, "\n");
+}
+
+/**
+ * @brief Loop of a worker: wait for a task, run it on its range, until the pool is destroyed
+ * @param worker Index of the worker
+*/
+void WorkerPool::workerLoop(uint worker){
+    // Bound before the worker allocates anything, so that its stack is on its node too
+    if (_cpus[worker] >= 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(_cpus[worker], &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    uint64_t done = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true){
+        _taskReady.wait(lock, [&](){
+            return _stop || _generation != done;
+        });
+        if (_stop){
+            return;
+        }
+        done = _generation;
+        const std::function<void(uint, size_t, size_t)>& task = *_task;
+        size_t n = _taskSize;
+        const size_t* bounds = _taskBounds;
+
+        lock.unlock();
+        size_t begin = bounds != nullptr ? bounds[worker] : rangeBegin(n, worker);
+        size_t end = bounds != nullptr ? bounds[worker + 1] : rangeBegin(n, worker + 1);
+        if (begin < end){
+            task(worker, begin, end);
+        }
+        lock.lock();
+
+        if (--_pending == 0){
+            _taskDone.notify_one();
+        }
+    }
+}
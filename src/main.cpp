@@ -4,11 +4,170 @@ Created: 24/02/2024
 */
 
 #include <iostream>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <csignal>
 #include <Window.hpp>
+#include <TrajectoryWriter.hpp>
+#include <TrajectoryReader.hpp>
+#include <TripleBuffer.hpp>
+#include <WorkerPool.hpp>
 
-int main(void){
+/**
+ * @brief Apply the gravity to a 3D set, measuring the conserved quantities on the sampled steps
+ * @param particles The 3D set of particles
+ * @param diagnostics The conservation log, does nothing if no file is open
+ * @param diagnostics_every Number of steps between two conservation samples
+ * @param step Number of the step
+*/
+template <typename T, typename TOffset>
+void apply_gravity(ParticleSystem3D<T, TOffset>& particles, ConservationLog& diagnostics, uint diagnostics_every, uint64_t step){
+    if (diagnostics.isOpen() && step % diagnostics_every == 0){
+        ConservationSample sample;
+        particles.applyGravity(&sample);
+        sample.step = step;
+        diagnostics.record(sample);
+    }
+    else {
+        particles.applyGravity();
+    }
+}
+
+/**
+ * @brief Run one frame of the 3D simulation
+ * @param particles The 3D set of particles
+ * @param window The window to draw in
+ * @param profiler The profiler timing the phases
+ * @param show_profiler Whether the profiler overlay is drawn
+ * @param trajectory The trajectory recorder, does nothing if no file is open
+ * @param diagnostics The conservation log, does nothing if no file is open
+ * @param diagnostics_every Number of steps between two conservation samples
+ * @param step Number of the step
+*/
+template <typename T, typename TOffset>
+void step_3d(ParticleSystem3D<T, TOffset>& particles, Window& window, FrameProfiler& profiler, bool show_profiler,
+             TrajectoryWriter& trajectory, ConservationLog& diagnostics, uint diagnostics_every, uint64_t step){
+    {
+        ProfileScope scope(profiler, PHASE_GRAVITY);
+        apply_gravity(particles, diagnostics, diagnostics_every, step);
+    }
+    {
+        ProfileScope scope(profiler, PHASE_DRAW);
+        window.draw_particles(particles);
+        if (show_profiler){
+            window.draw_profiler(profiler);
+        }
+    }
+    {
+        ProfileScope scope(profiler, PHASE_PRESENT);
+        window.update_window();
+    }
+    {
+        ProfileScope scope(profiler, PHASE_MOVE);
+        particles.updateParticlesPosition();
+    }
+    {
+        ProfileScope scope(profiler, PHASE_COLLISION);
+        particles.applyCollision();
+    }
+    trajectory.record(particles, step);
+}
+
+/**
+ * @brief Loop of the physics thread: step the 3D simulation and publish a snapshot after each step, until running is cleared
+ * @param particles The 3D set of particles, only used by this thread until it returns
+ * @param snapshots The snapshots read by the render thread
+ * @param profiler The profiler timing the phases of the steps, only written by this thread
+ * @param trajectory The trajectory recorder, does nothing if no file is open
+ * @param diagnostics The conservation log, does nothing if no file is open
+ * @param diagnostics_every Number of steps between two conservation samples
+ * @param rate Maximum number of steps per second, 0 for as many as possible
+ * @param running Cleared by the render thread to stop the loop
+ * @param steps Number of steps done, read by the render thread
+*/
+template <typename T, typename TOffset>
+void run_physics(ParticleSystem3D<T, TOffset>& particles, TripleBuffer<ParticleSystem3D<T, TOffset>>& snapshots, FrameProfiler& profiler,
+                 TrajectoryWriter& trajectory, ConservationLog& diagnostics, uint diagnostics_every, double rate,
+                 const std::atomic<bool>& running, std::atomic<uint64_t>& steps){
+    std::chrono::steady_clock::duration period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(rate > 0 ? 1 / rate : 0));
+    std::chrono::steady_clock::time_point next_step = std::chrono::steady_clock::now();
+
+    for (uint64_t step = 0; running.load(std::memory_order_relaxed); step++){
+        profiler.beginFrame();
+        {
+            ProfileScope scope(profiler, PHASE_GRAVITY);
+            apply_gravity(particles, diagnostics, diagnostics_every, step);
+        }
+        {
+            ProfileScope scope(profiler, PHASE_MOVE);
+            particles.updateParticlesPosition();
+        }
+        {
+            ProfileScope scope(profiler, PHASE_COLLISION);
+            particles.applyCollision();
+        }
+        trajectory.record(particles, step);
+        {
+            ProfileScope scope(profiler, PHASE_SNAPSHOT);
+            particles.copyState(snapshots.writeBuffer());
+            snapshots.publish();
+        }
+        if (rate > 0){
+            // Steps missed because of a slow step are not caught up
+            ProfileScope scope(profiler, PHASE_SLEEP);
+            next_step = std::max(next_step + period, std::chrono::steady_clock::now() - period);
+            std::this_thread::sleep_until(next_step);
+        }
+        profiler.endFrame();
+        steps.store(step + 1, std::memory_order_relaxed);
+    }
+}
 
-    std::srand(std::time(0));
+/**
+ * @brief Draw one frame of a recorded trajectory
+ * @param trajectory The trajectory being replayed
+ * @param particles Receives the particles of the frame
+ * @param frame Index of the frame to draw
+ * @param window The window to draw in
+ * @param profiler The profiler timing the phases
+ * @param show_profiler Whether the profiler overlay is drawn
+*/
+void step_replay(TrajectoryReader& trajectory, ParticleSystem3D<float>& particles, size_t frame, Window& window,
+                 FrameProfiler& profiler, bool show_profiler){
+    {
+        ProfileScope scope(profiler, PHASE_MOVE);
+        trajectory.readFrame(frame, particles);
+    }
+    {
+        ProfileScope scope(profiler, PHASE_DRAW);
+        window.draw_particles(particles);
+        if (show_profiler){
+            window.draw_profiler(profiler);
+        }
+    }
+    {
+        ProfileScope scope(profiler, PHASE_PRESENT);
+        window.update_window();
+    }
+}
+
+/* Set by Ctrl+C when there is no window to close */
+static volatile std::sig_atomic_t interrupted = 0;
+
+/**
+ * @brief Handler of SIGINT in headless mode, stopping the main loop so that the outputs are closed properly
+*/
+static void on_interrupt(int){
+    interrupted = 1;
+}
+
+int main(int argc, char** argv){
 
     /* Values used for nanosleep */
     /* 1 frame per 16.6 ms is equal to 60 fps */
@@ -26,22 +185,379 @@ int main(void){
     Vector<int> mouse_pos = {0, 0}; 
     bool mouse_button_down = false;
 
-    /* Create window */
-    Window window = Window(w_width, w_height);
-    
     bool EXIT = false;
+
+    /* Simulation mode, 2D by default, "--3d" for the 3D one */
+    bool mode_3d = false;
+    /* Precision of the 3D simulation: "float", "double" or "mixed" (double positions, float force kernel) */
+    const char* precision = "float";
+    /* Chrome trace written on exit when "--profile <file>" is given */
+    const char* trace_path = NULL;
+    /* Seed of the scene, "--seed <n>" to replay a previous run */
+    uint64_t seed = std::time(0);
+    /* Number of particles, "--particles <n>" */
+    uint64_t nb_particles = 300;
+    /* Radius of the particles, "--radius <px>" */
+    double radius = 10;
+    /* Particles drawn by the software rasterizer, "--renderer software", or by the SDL renderer, "--renderer sdl" */
+    bool software_rendering = false;
+    /* Initial distribution of the 3D simulation, "--scene box|disc|plummer" */
+    SceneDistribution distribution = SCENE_UNIFORM_BOX;
+    /* Trajectory of the 3D simulation, written when "--record <file>" is given */
+    const char* record_path = NULL;
+    TrajectoryOptions record_options;
+    /* Trajectory played instead of simulating, "--replay <file>" */
+    const char* replay_path = NULL;
+    /* Energy and momenta written every k steps when "--diagnostics <file>" is given, "--diagnostics-every <k>" */
+    const char* diagnostics_path = NULL;
+    uint diagnostics_every = 10;
+    /* 3D physics on its own thread, "--threaded", limited to "--physics-rate <hz>" steps per second (0 for no limit) */
+    bool threaded = false;
+    double physics_rate = 60;
+    /* Frames written by the software rasterizer to "--export <pattern|file|command>", without a window with "--headless" */
+    const char* export_path = NULL;
+    FrameExportOptions export_options;
+    bool headless = false;
+    /* Number of steps before quitting, "--steps <n>", 0 to run until closed */
+    uint64_t max_steps = 0;
+    /* Workers of the 3D force loop, "--workers <n>" (one per CPU by default), bound to their CPU unless "--no-pin" */
+    uint nb_workers = 0;
+    bool pin_workers = true;
+    /* Force loop shared between the workers by the interactions of the particles, cut again every "--rebalance <k>" steps
+       (0 for fixed ranges) */
+    uint rebalance_period = 10;
+    /* 3D particles reordered along a Morton curve every "--sort <k>" steps, 0 (by default) to keep their order */
+    uint sort_period = 0;
+    /* 3D gravity computed by worker processes, one per spatial domain, "--domains <p>" (0 for none) */
+    uint nb_domains = 0;
+    /* Softening, regularization of close pairs, time step and contacts along the moves, "--softening", "--softening-length",
+       "--regularize", "--dt", "--swept" */
+    GravityParameters gravity;
+    /* The 2D gravity stays Newtonian unless "--softening" or "--softening-length" is given */
+    bool softening_given = false;
+    for (int i = 1; i < argc; i++){
+        if (std::strcmp(argv[i], "--3d") == 0){
+            mode_3d = true;
+        }
+        else if (std::strcmp(argv[i], "--precision") == 0 && i + 1 < argc){
+            precision = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc){
+            trace_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc){
+            seed = std::strtoull(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--particles") == 0 && i + 1 < argc){
+            nb_particles = std::strtoull(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--radius") == 0 && i + 1 < argc){
+            radius = std::strtod(argv[++i], NULL);
+        }
+        else if (std::strcmp(argv[i], "--renderer") == 0 && i + 1 < argc){
+            software_rendering = std::strcmp(argv[++i], "software") == 0;
+        }
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc){
+            record_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--record-every") == 0 && i + 1 < argc){
+            record_options.sampleEvery = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--record-ids") == 0 && i + 1 < argc){
+            // Range "first-last" of identifiers
+            char* end = NULL;
+            uint64_t first = std::strtoull(argv[++i], &end, 10);
+            uint64_t last = *end == '-' ? std::strtoull(end + 1, NULL, 10) : first;
+            for (uint64_t id = first; id <= last; id++){
+                record_options.ids.push_back(id);
+            }
+        }
+        else if (std::strcmp(argv[i], "--record-velocities") == 0){
+            record_options.velocities = true;
+        }
+        else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc){
+            replay_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--softening") == 0 && i + 1 < argc){
+            i++;
+            softening_given = true;
+            if (std::strcmp(argv[i], "none") == 0){
+                gravity.kernel = SOFTENING_NONE;
+            }
+            else if (std::strcmp(argv[i], "spline") == 0){
+                gravity.kernel = SOFTENING_SPLINE;
+            }
+            else if (std::strcmp(argv[i], "plummer") == 0){
+                gravity.kernel = SOFTENING_PLUMMER;
+            }
+        }
+        else if (std::strcmp(argv[i], "--softening-length") == 0 && i + 1 < argc){
+            gravity.softening = std::strtod(argv[++i], NULL);
+            softening_given = true;
+        }
+        else if (std::strcmp(argv[i], "--regularize") == 0 && i + 1 < argc){
+            gravity.regularization = std::strtod(argv[++i], NULL);
+        }
+        else if (std::strcmp(argv[i], "--dt") == 0 && i + 1 < argc){
+            gravity.dt = std::strtod(argv[++i], NULL);
+        }
+        else if (std::strcmp(argv[i], "--swept") == 0){
+            gravity.sweptCollisions = true;
+        }
+        else if (std::strcmp(argv[i], "--diagnostics") == 0 && i + 1 < argc){
+            diagnostics_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--diagnostics-every") == 0 && i + 1 < argc){
+            diagnostics_every = std::max(1ul, std::strtoul(argv[++i], NULL, 10));
+        }
+        else if (std::strcmp(argv[i], "--export") == 0 && i + 1 < argc){
+            export_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--export-every") == 0 && i + 1 < argc){
+            export_options.exportEvery = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--export-threads") == 0 && i + 1 < argc){
+            export_options.nbThreads = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--export-wait") == 0){
+            export_options.wait = true;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0){
+            headless = true;
+        }
+        else if (std::strcmp(argv[i], "--steps") == 0 && i + 1 < argc){
+            max_steps = std::strtoull(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc){
+            nb_workers = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--no-pin") == 0){
+            pin_workers = false;
+        }
+        else if (std::strcmp(argv[i], "--rebalance") == 0 && i + 1 < argc){
+            rebalance_period = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--sort") == 0 && i + 1 < argc){
+            sort_period = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--domains") == 0 && i + 1 < argc){
+            nb_domains = std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (std::strcmp(argv[i], "--threaded") == 0){
+            threaded = true;
+        }
+        else if (std::strcmp(argv[i], "--physics-rate") == 0 && i + 1 < argc){
+            physics_rate = std::strtod(argv[++i], NULL);
+        }
+        else if (std::strcmp(argv[i], "--scene") == 0 && i + 1 < argc){
+            i++;
+            if (std::strcmp(argv[i], "disc") == 0){
+                distribution = SCENE_EXPONENTIAL_DISC;
+            }
+            else if (std::strcmp(argv[i], "plummer") == 0){
+                distribution = SCENE_PLUMMER_SPHERE;
+            }
+        }
+    }
+    std::cout << "Seed: " << seed << std::endl;
+    bool use_double = std::strcmp(precision, "double") == 0;
+    bool use_mixed = std::strcmp(precision, "mixed") == 0;
+
+    /* Domain workers, forked before any window, thread or export pipe exists, the black hole being one more particle */
+    DomainDecomposition<float> domains;
+    DomainDecomposition<double> domains_double;
+    DomainDecomposition<double, float> domains_mixed;
+    if (mode_3d && replay_path == NULL && nb_domains > 0){
+        bool started = use_double ? domains_double.start(nb_domains, nb_particles + 1)
+                     : use_mixed ? domains_mixed.start(nb_domains, nb_particles + 1)
+                     : domains.start(nb_domains, nb_particles + 1);
+        if (started){
+            std::cout << "Domains: " << nb_domains << " processes" << std::endl;
+        }
+    }
+
+    /* Create window, offscreen only when headless */
+    Window window = Window(w_width, w_height, headless);
+    window.set_software_rendering(software_rendering);
+    if (headless){
+        std::signal(SIGINT, on_interrupt);
+    }
+
+    /* Frames of the software rasterizer, encoded by a pool of threads */
+    FrameExporter exporter;
+    if (export_path != NULL){
+        if (!exporter.open(export_path, w_width, w_height, export_options)){
+            window.close_window();
+            return 1;
+        }
+        window.set_software_rendering(true);
+        window.set_exporter(&exporter);
+        if (exporter.format() == FRAME_RAW_RGB){
+            std::cout << "Export: raw rgb24 frames of " << w_width << "x" << w_height << std::endl;
+        }
+    }
+
+    /* Frame profiler, its overlay is toggled with "p" */
+    FrameProfiler profiler;
+    bool show_profiler = false;
     
     /* Test */
     // Generating particles
-    auto particles = Particle::createParticleSet(300, 10, w_width, w_height);
+    std::vector<Particle> particles;
+    std::unique_ptr<WorkerPool> workers;
+    ParticleSystem3D<float> particles_3d;
+    ParticleSystem3D<double> particles_3d_double;
+    ParticleSystem3D<double, float> particles_3d_mixed;
+    if (replay_path != NULL){
+        mode_3d = false;
+    }
+    else if (mode_3d){
+        // Centered in the window, the box being the same spawn area as in 2D
+        SceneParameters scene;
+        scene.distribution = distribution;
+        scene.nbParticles = nb_particles;
+        scene.radius = radius;
+        scene.center[0] = w_width / 2.0;
+        scene.center[1] = w_height / 2.0;
+        scene.halfSize[0] = w_width;
+        scene.halfSize[1] = w_height;
+        scene.halfSize[2] = std::min(w_width, w_height);
+        scene.scaleLength = std::min(w_width, w_height) / 4.0;
+        scene.seed = seed;
+
+        // The workers fill the scene, so that each one finds the particles it owns on its own NUMA node
+        workers.reset(new WorkerPool(nb_workers, pin_workers));
+        workers->print(stdout);
+
+        if (use_double){
+            particles_3d_double = ParticleSystem3D<double>::createScene(scene, workers.get());
+            particles_3d_double.setGravity(gravity);
+            particles_3d_double.setBalancePeriod(rebalance_period);
+            particles_3d_double.setSortPeriod(sort_period);
+            particles_3d_double.setDomains(domains_double.isRunning() ? &domains_double : nullptr);
+        }
+        else if (use_mixed){
+            particles_3d_mixed = ParticleSystem3D<double, float>::createScene(scene, workers.get());
+            particles_3d_mixed.setGravity(gravity);
+            particles_3d_mixed.setBalancePeriod(rebalance_period);
+            particles_3d_mixed.setSortPeriod(sort_period);
+            particles_3d_mixed.setDomains(domains_mixed.isRunning() ? &domains_mixed : nullptr);
+        }
+        else {
+            particles_3d = ParticleSystem3D<float>::createScene(scene, workers.get());
+            particles_3d.setGravity(gravity);
+            particles_3d.setBalancePeriod(rebalance_period);
+            particles_3d.setSortPeriod(sort_period);
+            particles_3d.setDomains(domains.isRunning() ? &domains : nullptr);
+        }
+    }
+    else {
+        particles = Particle::createParticleSet(nb_particles, radius, w_width, w_height, seed);
+    }
+    Softening<double> softening_2d = softening_given ? Softening<double>(gravity.kernel, gravity.softening)
+                                                     : Softening<double>(SOFTENING_NONE, 0);
+
+    /* Replay: frames per displayed frame (negative to play backward), paused with space */
+    TrajectoryReader replay;
+    ParticleSystem3D<float> particles_replay;
+    double playhead = 0;
+    double replay_speed = 1;
+    bool replay_paused = false;
+    if (replay_path != NULL){
+        if (!replay.open(replay_path) || replay.frameCount() == 0){
+            window.close_window();
+            return 1;
+        }
+        std::cout << "Replay: " << replay.frameCount() << " frames, steps " << replay.frameStep(0) << " to "
+                  << replay.frameStep(replay.frameCount() - 1) << std::endl;
+    }
     window.set_rendering_color(0, 255, 255, 255);
 
-    while (!EXIT){
-        while (SDL_PollEvent(&e) != 0){
+    TrajectoryWriter trajectory;
+    if (mode_3d && record_path != NULL){
+        trajectory.open(record_path, record_options);
+    }
+    ConservationLog diagnostics;
+    if (mode_3d && diagnostics_path != NULL){
+        diagnostics.open(diagnostics_path);
+    }
+    uint64_t step = 0;
+
+    /* Physics thread of the threaded mode, the render loop draws the latest snapshot it published */
+    TripleBuffer<ParticleSystem3D<float>> snapshots;
+    TripleBuffer<ParticleSystem3D<double>> snapshots_double;
+    TripleBuffer<ParticleSystem3D<double, float>> snapshots_mixed;
+    FrameProfiler physics_profiler;
+    std::atomic<bool> physics_running {true};
+    std::atomic<uint64_t> physics_steps {0};
+    std::thread physics;
+    // Offscreen, the main loop draws every step itself
+    threaded = threaded && mode_3d && !headless;
+    if (threaded){
+        physics = std::thread([&](){
+            if (use_double){
+                run_physics(particles_3d_double, snapshots_double, physics_profiler, trajectory, diagnostics, diagnostics_every,
+                            physics_rate, physics_running, physics_steps);
+            }
+            else if (use_mixed){
+                run_physics(particles_3d_mixed, snapshots_mixed, physics_profiler, trajectory, diagnostics, diagnostics_every,
+                            physics_rate, physics_running, physics_steps);
+            }
+            else {
+                run_physics(particles_3d, snapshots, physics_profiler, trajectory, diagnostics, diagnostics_every,
+                            physics_rate, physics_running, physics_steps);
+            }
+        });
+    }
+
+    while (!EXIT && !interrupted){
+        profiler.beginFrame();
+        while (!headless && SDL_PollEvent(&e) != 0){
             if (e.type == SDL_KEYDOWN){
                 if (e.key.keysym.sym == SDLK_ESCAPE){
                     EXIT = true;
                 }
+                if (e.key.keysym.sym == SDLK_p){
+                    show_profiler = !show_profiler;
+                }
+                if (e.key.keysym.sym == SDLK_r && !exporter.isOpen()){
+                    window.set_software_rendering(!window.is_software_rendering());
+                    std::cout << "Renderer: " << (window.is_software_rendering() ? "software" : "sdl") << std::endl;
+                }
+                if (replay_path != NULL){
+                    double last_frame = replay.frameCount() - 1;
+                    switch (e.key.keysym.sym){
+                        case SDLK_SPACE:
+                            replay_paused = !replay_paused;
+                            break;
+                        // Direction while playing, one frame at a time while paused
+                        case SDLK_LEFT:
+                            replay_speed = -std::abs(replay_speed);
+                            if (replay_paused){
+                                playhead = std::max(0.0, std::floor(playhead) - 1);
+                            }
+                            break;
+                        case SDLK_RIGHT:
+                            replay_speed = std::abs(replay_speed);
+                            if (replay_paused){
+                                playhead = std::min(last_frame, std::floor(playhead) + 1);
+                            }
+                            break;
+                        case SDLK_UP:
+                            replay_speed = std::min(replay_speed * 2, 256.0);
+                            replay_speed = std::max(replay_speed, -256.0);
+                            break;
+                        case SDLK_DOWN:
+                            replay_speed /= 2;
+                            break;
+                        case SDLK_HOME:
+                            playhead = 0;
+                            break;
+                        case SDLK_END:
+                            playhead = last_frame;
+                            break;
+                    }
+                }
             }
 
             if (e.type == SDL_MOUSEBUTTONDOWN){
@@ -57,6 +573,13 @@ int main(void){
                 }
             }
 
+            if (e.type == SDL_MOUSEWHEEL && e.wheel.y != 0){
+                // Zoom around the cursor
+                int x, y;
+                SDL_GetMouseState(&x, &y);
+                window.zoom_window(e.wheel.y > 0 ? 1.25f : 0.8f, x, y);
+            }
+
             if (e.type == SDL_MOUSEMOTION){
                 if (mouse_button_down){
                     window.move_window(e.motion.x - mouse_pos.x, e.motion.y - mouse_pos.y);
@@ -65,13 +588,138 @@ int main(void){
                 }
             }
         }
-        Particle::applyGravity(particles);
-        window.draw_particles(particles);
-        window.update_window();
-        Particle::updateParticlesPosition(particles);
-        Particle::applyCollision(particles);
-        nanosleep(&tim, NULL);
+        if (replay_path != NULL){
+            step_replay(replay, particles_replay, (size_t) playhead, window, profiler, show_profiler);
+            if (!replay_paused){
+                playhead = std::min<double>(std::max(0.0, playhead + replay_speed), replay.frameCount() - 1);
+            }
+        }
+        else if (threaded){
+            {
+                ProfileScope scope(profiler, PHASE_DRAW);
+                if (use_double){
+                    snapshots_double.acquire();
+                    window.draw_particles(snapshots_double.readBuffer());
+                }
+                else if (use_mixed){
+                    snapshots_mixed.acquire();
+                    window.draw_particles(snapshots_mixed.readBuffer());
+                }
+                else {
+                    snapshots.acquire();
+                    window.draw_particles(snapshots.readBuffer());
+                }
+                if (show_profiler){
+                    window.draw_profiler(profiler, &physics_profiler);
+                }
+            }
+            {
+                ProfileScope scope(profiler, PHASE_PRESENT);
+                window.update_window();
+            }
+        }
+        else if (mode_3d){
+            if (use_double){
+                step_3d(particles_3d_double, window, profiler, show_profiler, trajectory, diagnostics, diagnostics_every, step);
+            }
+            else if (use_mixed){
+                step_3d(particles_3d_mixed, window, profiler, show_profiler, trajectory, diagnostics, diagnostics_every, step);
+            }
+            else {
+                step_3d(particles_3d, window, profiler, show_profiler, trajectory, diagnostics, diagnostics_every, step);
+            }
+        }
+        else {
+            {
+                ProfileScope scope(profiler, PHASE_GRAVITY);
+                Particle::applyGravity(particles, softening_2d);
+            }
+            {
+                ProfileScope scope(profiler, PHASE_DRAW);
+                window.draw_particles(particles);
+                if (show_profiler){
+                    window.draw_profiler(profiler);
+                }
+            }
+            {
+                ProfileScope scope(profiler, PHASE_PRESENT);
+                window.update_window();
+            }
+            {
+                ProfileScope scope(profiler, PHASE_MOVE);
+                Particle::updateParticlesPosition(particles);
+            }
+            {
+                ProfileScope scope(profiler, PHASE_COLLISION);
+                Particle::applyCollision(particles);
+            }
+        }
+        if (!headless){
+            ProfileScope scope(profiler, PHASE_SLEEP);
+            nanosleep(&tim, NULL);
+        }
         window.clear_window();
+        profiler.endFrame();
+        step++;
+        if (max_steps != 0 && step >= max_steps){
+            EXIT = true;
+        }
+    }
+
+    if (threaded){
+        physics_running = false;
+        physics.join();
+        std::cout << "Physics: " << physics_steps << " steps in " << step << " frames" << std::endl;
+    }
+
+    if (mode_3d){
+        const OctreeStats& tree = use_double ? particles_3d_double.getTreeStats()
+                                : use_mixed ? particles_3d_mixed.getTreeStats()
+                                : particles_3d.getTreeStats();
+        std::cout << "Octree: " << tree.builds << " builds, " << tree.refits << " refits, " << tree.reinsertedParticles
+                  << " particles reinserted, " << tree.leafSplits << " leaf splits, " << tree.leafMerges << " merges" << std::endl;
+
+        const BalanceStats& balance = use_double ? particles_3d_double.getBalanceStats()
+                                    : use_mixed ? particles_3d_mixed.getBalanceStats()
+                                    : particles_3d.getBalanceStats();
+        if (balance.steps > 0){
+            std::cout << "Balance: " << balance.rebalances << " partitions, imbalance " << balance.lastImbalance << " last, "
+                      << balance.imbalanceSum / balance.steps << " mean" << std::endl;
+            for (size_t w = 0; w < balance.workerSeconds.size(); w++){
+                std::cout << "  worker " << w << ": " << balance.workerSeconds[w] << " s, " << balance.workerInteractions[w]
+                          << " interactions" << std::endl;
+            }
+        }
+    }
+
+    if (nb_domains > 0){
+        uint64_t domain_steps = use_double ? domains_double.stepCount() : use_mixed ? domains_mixed.stepCount() : domains.stepCount();
+        double last_imbalance = use_double ? domains_double.lastImbalance() : use_mixed ? domains_mixed.lastImbalance() : domains.lastImbalance();
+        double mean_imbalance = use_double ? domains_double.meanImbalance() : use_mixed ? domains_mixed.meanImbalance() : domains.meanImbalance();
+        double imported = use_double ? domains_double.meanImportedBodies() : use_mixed ? domains_mixed.meanImportedBodies() : domains.meanImportedBodies();
+        std::cout << "Domains: " << domain_steps << " steps, imbalance " << last_imbalance << " last, " << mean_imbalance
+                  << " mean, " << imported << " bodies imported per domain per step" << std::endl;
+    }
+
+    if (diagnostics.isOpen()){
+        diagnostics.close();
+        std::cout << "Diagnostics: " << diagnostics.sampleCount() << " samples, energy drift " << diagnostics.maxEnergyDrift()
+                  << ", angular momentum drift " << diagnostics.maxAngularMomentumDrift() << std::endl;
+    }
+
+    if (trajectory.isOpen()){
+        trajectory.close();
+        std::cout << "Trajectory: " << trajectory.framesWritten() << " frames, " << trajectory.bytesWritten() << " bytes, "
+                  << trajectory.framesDropped() << " dropped" << std::endl;
+    }
+
+    if (exporter.isOpen()){
+        exporter.close();
+        std::cout << "Export: " << exporter.framesWritten() << " frames, " << exporter.framesDropped() << " dropped" << std::endl;
+    }
+
+    if (trace_path != NULL){
+        profiler.writeChromeTrace(trace_path, threaded ? &physics_profiler : nullptr);
     }
 
     window.close_window();